@@ -2,12 +2,116 @@
 
 /* Choose one of the random generators. */
 
-#include "random/lfsr.h"
+#if RANDOM_STREAMS
+	#include "random/xoshiro.h"
+	#define random8 xoshiro_rand8
+	#define random16 xoshiro_rand16
+	#define random32 xoshiro_rand32
+	#define random_state xoshiro_state
+	#define random_get_state xoshiro_get_state
+	#define random_set_state xoshiro_set_state
+#else
+	#include "random/lfsr.h"
+	#define random8 lfsr_rand8
+	#define random16 lfsr_rand16
+	#define random32 lfsr_rand32
+	#define random_state lfsr_state
+	#define random_get_state lfsr_get_state
+	#define random_set_state lfsr_set_state
+#endif
+
 #include "util/usart.h"
 #include "util/spi.h"
+#include "util/power.h"
+#include "util/counter.h"
+#include "util/timeout.h"
+#include "util/checkpoint.h"
 #include <math.h>
 #include <stdio.h>
 #include <util/delay.h>
+#include <avr/wdt.h>
+
+/* Number of individuals stored in this node (its partition of the population). */
+popsize_t nodePopulationSize = NODE_POPULATION_MAX;
+
+#if CHECKPOINT_INTERVAL
+#if CHECKPOINT_BYTES > CHECKPOINT_MAX_SIZE
+	#error "The checkpoint does not fit in the EEPROM, reduce NODE_POPULATION_MAX or set CHECKPOINT_INTERVAL to 0"
+#endif
+
+/* Epoch of the current run, it tells the checkpoints of this run from older ones. */
+static uint16_t epoch;
+#endif
+
+#if NODE_ID == 0 && CHECKPOINT_INTERVAL
+/* Set after the first run, since only the first run after a reset can resume from a checkpoint. */
+static uint8_t started;
+#endif
+
+#if NODE_ID == 0
+/* Health of each node (NODE_ALIVE, NODE_SUSPECT or NODE_DEAD) and handshakes it missed in a row. */
+static uint8_t nodeHealth[NUM_NODES];
+static uint8_t nodeMisses[NUM_NODES];
+
+/* Set when a node dies, so its individuals are moved to the other nodes. */
+static uint8_t healthChanged;
+#endif
+
+#if NODE_ID == 0 && LINK_CALIBRATION
+/* SPI clock setting used with each slave. */
+static uint8_t linkClock[NUM_NODES];
+#endif
+
+#if WARM_START
+/* Set when the previous run ended with all nodes aligned, so this one starts from its final population. */
+static uint8_t warm;
+#endif
+
+/* Indexes of the ELITES best individuals of the current population (the best one first) and their
+fitness values, found by fitnessFM. */
+static popsize_t eliteIndex[ELITES];
+static fitness_t eliteFitness[ELITES];
+
+#if STEADY_STATE
+/* Heap of the individuals of this node by fitness value (the worst one on top), and the new individuals
+this node got in the current step of the steady-state GA. */
+static popsize_t worstHeap[NODE_POPULATION_MAX];
+static chromosome_t offspring[STEADY_OFFSPRING][DIMENSION];
+static uint8_t offspringCount;
+#endif
+
+#if CELLULAR
+/* Rows of the grid next to the ones of this node (the last row of the previous node followed by the
+first row of the next one) and their fitness values, received once per generation. */
+static chromosome_t halo[2 * CELL_WIDTH][DIMENSION];
+static fitness_t haloFitness[2 * CELL_WIDTH];
+
+/* Offsets of row and column of each cell of a neighbourhood. */
+static const int8_t cellRow[CELL_NEIGHBOURS] = {0, -1, 1, 0, 0};
+static const int8_t cellColumn[CELL_NEIGHBOURS] = {0, 0, 0, -1, 1};
+#endif
+
+#if MUTATION_SKIP
+/* Cumulative distributions (scaled to 65536) of the full chunks of MUTATION_TABLE bits and of the
+bits in the last chunk skipped before a flipped bit (see mutationTableFM). */
+static uint16_t chunkThreshold[MUTATION_TABLE];
+static uint16_t bitThreshold[MUTATION_TABLE];
+#endif
+
+#if NODE_ID == 0 && GA_MODE == GA_MODE_PARTITIONED
+/* Global index of the first individual of each node, for the current population (populationStart)
+and for the new one (partitionStart). They only differ in the generation a node dies. */
+static popsize_t populationStart[NUM_NODES + 1];
+static popsize_t partitionStart[NUM_NODES + 1];
+
+/* Relative speed of each node. */
+static float nodeSpeed[NUM_NODES];
+
+#if !CALIBRATE_PARTITIONS
+/* Relative speed of each node, as configured. */
+static const float nodeWeights[NUM_NODES] = NODE_WEIGHTS;
+#endif
+#endif
 
 /** 
  * This is the core function of the genetic algorithm. It runs all the modules
@@ -17,136 +121,161 @@
  * @param population A vector containing the individuals.
  * @return The index of the best individual in the population after the last generation.
  */
-popsize_t geneticAlgorithmFM(fitness_t evaluation[], chromosome_t population[][DIMENSION])
+popsize_t geneticAlgorithmFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS])
 {
 	popsize_t iBest;
+#if GA_MODE == GA_MODE_PARTITIONED || NODE_ID == 0
+	generationsize_t first;
 	generationsize_t k;
+#endif
+#if STEADY_STATE
+	popsize_t s;
+#endif
 	
-#if NODE_ID == 0
-	/* These variables are used to store and verify what is the best individual. */
-	chromosome_t bestIndividuals[NUM_NODES][DIMENSION];
-	normalization_t normalizedChromosome[DIMENSION];
-	chromosome_t bestIndividual[DIMENSION];
-	fitness_t bestFitnessValue;
-	fitness_t fitnessValue;
+#if NODE_ID == 0 && GA_MODE != GA_MODE_MASTER_WORKER
+	/* These variables are used to store the best individuals of all nodes. */
+	chromosome_t bestIndividuals[ELITES][DIMENSION];
+	fitness_t bestFitness[ELITES];
 	dimensionsize_t j;
+	uint8_t e;
 	
 #endif 		
 
-	/* Synchronize before begin. */
-	spi_data_t data;
-	
-#if NODE_ID == 0
-	
-	while(1)
-	{
-		/* Send command and receive a response. */
-		PORTB &= !(1 << 2);
-		
-		SPDR = CMD_SYNC;
-		while(!(SPSR & (1 << SPIF)));
-		data = SPDR;
-		
-		_delay_ms(1);
+#if POWER_SCALING
+	/* Compute and transfer at full speed, only the waits for the other nodes slow down. */
+	power_set_div(CPU_DIV_FAST);
+#endif
 
-		SPDR = DUMMY;
-		while(!(SPSR & (1 << SPIF)));
-		data = SPDR;
-		
-		PORTB |= (1 << 2);
-		
-		_delay_ms(1);
-		
-		/* Check if it received a ACK. */
-		if(data == ACK_SYNC)
-		{
-			_delay_ms(1);
-			break;
-			
-		}
+	/* Synchronize before begin and agree on the population partition (or on a checkpoint to resume
+	from). A warm start skips it, since the nodes are still aligned (and partitioned) from the previous run. */
+#if GA_MODE == GA_MODE_PARTITIONED || NODE_ID == 0
+	first = 0;
+#endif
+#if WARM_START
+	if(!warm)
+#endif
+	{
+#if GA_MODE == GA_MODE_PARTITIONED || NODE_ID == 0
+		first = synchronizationFM(population);
+#else
+		synchronizationFM(population);
+#endif
 	}
+
+#if GA_MODE == GA_MODE_MASTER_WORKER && NODE_ID != 0
+
+	/* Workers hold no population, they only evaluate the batches streamed by the master. */
+	evaluationWorkerFM(evaluation, population);
+	iBest = 0;
 	
 #else
 
-	while(1)
+	/* Initializes the population (a resumed run already loaded it from the checkpoint). */
+#if WARM_START
+	if(warm)
 	{
-		while(!(SPSR & (1 << SPIF)));
-		data = SPDR;
-		
-		if(data == CMD_SYNC)
-		{
-			SPDR = ACK_SYNC ;
-			while(!(SPSR & (1 << SPIF)));
-			break;
-		}
+#if CHECKPOINT_INTERVAL
+		/* There is no CMD_SYNC, so every node moves to the next epoch by itself (as agreeCheckpointFM
+		does), otherwise the checkpoints of this run would mix with the ones of the previous run. */
+		epoch++;
+#endif
+		warmStartFM(population);
+	}
+	else if(first == 0)
+	{
+		initializationFM(population);
+	}
+#else
+	if(first == 0)
+	{
+		initializationFM(population);
 	}
-
 #endif
-
-
-	/* Initializes the population */
-	initializationFM(population);
+	
+#if MUTATION_SKIP
+	mutationTableFM();
+#endif
 	
 	/* Calculates the fitness for all individuals and save the best individual index */
-	iBest = fitnessFM(evaluation, population);
+	iBest = fitnessFM(evaluation, population, 0);
+#if STEADY_STATE
+	worstHeapFM(evaluation);
+#endif
 		
-	for(k = 0; k < NUM_GENERATIONS; k++)
+	for(k = first; k < NUM_GENERATIONS; k++)
 	{
+#if STEADY_STATE
+		/* Each step only evaluates its new individuals, so a generation is made of STEADY_STEPS steps. */
+		for(s = 0; s < STEADY_STEPS; s++)
+		{
+			steadyStateFM(evaluation, population);
+		}
+#else
 		
 				/* Generates a new population */
-		newPopulationFM(evaluation, population, iBest);
+		newPopulationFM(evaluation, population);
+		
+		/* Calculates the fitness again (the elites keep theirs) and saves the best individual */
+		iBest = fitnessFM(evaluation, population, ELITES);
+#endif
 		
-		/* Calculates the fitness again and saves the best individual */
-		iBest = fitnessFM(evaluation, population);			
+#if CHECKPOINT_INTERVAL
+		/* All nodes save the same generation, so the checkpoints are consistent. */
+		if((k + 1) % CHECKPOINT_INTERVAL == 0 && k + 1 < NUM_GENERATIONS)
+		{
+			checkpointFM(population, k + 1);
+		}
+#endif
 	}
 	
-
+#if CHECKPOINT_INTERVAL && NUM_GENERATIONS > CHECKPOINT_INTERVAL
+	/* An empty checkpoint of the last generation marks the run as finished, so it is never resumed. */
+	checkpoint_begin();
+	checkpoint_commit(epoch, NUM_GENERATIONS);
+#endif
+	
+#if STEADY_STATE
+	/* The individuals were replaced one by one, so find the elites of the final population. */
+	iBest = elitesFM(evaluation);
+#endif
+	
+#endif
 	
 	/* At this point, the GA already finished. Therefore, collect the best 
 	individual of each salve to see what is the best one between all uCs. */
 	
-#if NODE_ID == 0 /* Master */
+#if NODE_ID == 0 && GA_MODE == GA_MODE_MASTER_WORKER
+
+	/* The master already holds the whole population, so just release the workers. */
+	continueAllOperationsFM();
+
+#elif NODE_ID == 0 /* Master */
 
 	/* Collect the best individuals of all microcontrollers. */
-	collectBestIndividualsFM(bestIndividuals, population, iBest);
+	collectBestIndividualsFM(bestIndividuals, bestFitness, population);
 	
-	/* Define the best individual (from master) as the best one. */
-	for(j = 0; j < DIMENSION; j++)
-	{
-		bestIndividual[j] = bestIndividuals[0][j];
-	}
-	
-	normalizationFM(bestIndividual, normalizedChromosome);
-	bestFitnessValue = evaluationFM(normalizedChromosome);
-	
-	for(k = 1; k < NUM_NODES; k++)
+	/* Put them in the positions of the elites of the master, so the best one is in position iBest. */
+	for(e = 0; e < ELITES; e++)
 	{
-		normalizationFM(bestIndividuals[k], normalizedChromosome);
-		fitnessValue = evaluationFM(normalizedChromosome);
-		if(fitnessValue < bestFitnessValue)
+		for(j = 0; j < DIMENSION; j++)
 		{
-			for(j = 0; j < DIMENSION; j++)
-			{	
-				/* If a better individual was found, replace the best one in the master. */
-				bestIndividual[j] = bestIndividuals[k][j];
-			}
-
-			/* Update the best individual aux variables. */
-			normalizationFM(bestIndividual, normalizedChromosome);
-			bestFitnessValue = evaluationFM(normalizedChromosome);
+			SET_GENE(population, eliteIndex[e], j, bestIndividuals[e][j]);	
 		}
+		evaluation[eliteIndex[e]] = bestFitness[e];
+		eliteFitness[e] = bestFitness[e];
 	}
 	
-	/* Put the best individual in position iBest of the master. */
-	for(j = 0; j < DIMENSION; j++)
-	{
-		population[iBest][j] = bestIndividual[j];	
-	}
-	
-#else /* Slave */
+#elif GA_MODE != GA_MODE_MASTER_WORKER /* Slave */
 
-	waitSendBestIndividuaFM(population, iBest);
+	waitSendBestIndividuaFM(population);
+
+#endif
 
+#if WARM_START && NODE_ID == 0
+	/* A slave that failed may not be aligned anymore, so it has to synchronize again. */
+	warm = slavesAliveFM();
+#elif WARM_START
+	warm = 1;
 #endif
 	
 	return iBest;
@@ -157,1024 +286,3879 @@ popsize_t geneticAlgorithmFM(fitness_t evaluation[], chromosome_t population[][D
  *
  * @param population A vector containing the individuals.
  */
-void initializationFM(chromosome_t population[][DIMENSION])
+void initializationFM(population_t population[][POPULATION_COLUMNS])
 {	
 	popsize_t i;
+	
+	for(i = 0; i < nodePopulationSize; i++)
+	{
+		randomIndividualFM(population, i);
+	}
+}
+
+/** 
+ * This function generates a random individual.
+ *
+ * @param population A vector containing the individuals.
+ * @param i The index of the individual to be generated.
+ */
+void randomIndividualFM(population_t population[][POPULATION_COLUMNS], popsize_t i)
+{
 	dimensionsize_t j;
 	
-	for(i = 0; i < NODE_POPULATION_SIZE; i++)
+	for(j = 0; j < DIMENSION; j++)
 	{
-		for(j = 0; j < DIMENSION; j++)
-		{
-			/* Each individual is a random integer number */
-#if CHROMOSOME_SIZE == 32
-			population[i][j] = lfsr_rand32();		
-#elif CHROMOSOME_SIZE == 16
-			population[i][j] = lfsr_rand16();		
+		/* Each gene is a random integer number */
+#if CHROMOSOME_SIZE > 16
+		SET_GENE(population, i, j, random32() & GENE_MAX);		
+#elif CHROMOSOME_SIZE > 8
+		SET_GENE(population, i, j, random16() & GENE_MAX);		
 #else
-			population[i][j] = lfsr_rand8();	
+		SET_GENE(population, i, j, random8() & GENE_MAX);	
 #endif
-		}
 	}
 }
 
+#if INDIVIDUAL_COPY
+
 /** 
- * This function calculates the fitness value for the whole population. Before that, the
- * individuals are normalized to a range where the solution might be in.
+ * This function copies the genes of an individual to a vector (see INDIVIDUAL).
  *
- * @param evaluation A vector that will store the fitness values for the individuals.
  * @param population A vector containing the individuals.
- * @return The index of the best individual in the population after the last generation.
+ * @param i The index of the individual.
+ * @param x A vector that will store the genes.
+ * @return The vector x.
  */
-popsize_t fitnessFM(fitness_t evaluation[], chromosome_t population[][DIMENSION])
+chromosome_t *loadIndividualFM(population_t population[][POPULATION_COLUMNS], popsize_t i, chromosome_t x[])
 {
-	popsize_t i;
-	popsize_t iBest;
-	normalization_t normalizedChromosome[DIMENSION];
+	dimensionsize_t j;
 	
-	for (i = 0, iBest = 0; i < NODE_POPULATION_SIZE; i++)
+	for(j = 0; j < DIMENSION; j++)
 	{
-		/* First, normalize the individual */
-		normalizationFM(population[i], normalizedChromosome);
-				
-		/* The evaluation function (evaluationFM) must be defined by the user */
-		evaluation[i] = evaluationFM(normalizedChromosome); 
-		
-		if (evaluation[i] < evaluation[iBest])
-		{
-			iBest = i;
-		}	
+		x[j] = GET_GENE(population, i, j);
 	}
-	return iBest;
+	
+	return x;
 }
 
 /** 
- * This function normalizes an individual to an specified range (between NORMALIZATION_MIN and NORMALIZATION_MAX).
+ * This function copies a vector to the genes of an individual (see STORE_INDIVIDUAL).
  *
- * @param chromesome A individual of the population.
- * @param normalizedChromesome The normalized individual.
+ * @param population A vector containing the individuals.
+ * @param i The index of the individual.
+ * @param x A vector containing the genes.
  */
-void normalizationFM(chromosome_t chromesome[], normalization_t normalizedChromesome[])
+void storeIndividualFM(population_t population[][POPULATION_COLUMNS], popsize_t i, chromosome_t x[])
 {
 	dimensionsize_t j;
+	
 	for(j = 0; j < DIMENSION; j++)
 	{
-	    /* Applies a normalized gain on the chromosome */
-		normalizedChromesome[j] = NORMALIZATION_MIN + ((normalization_t) NORMALIZED_GAIN) * chromesome[j];
+		SET_GENE(population, i, j, x[j]);
 	}
-
 }
 
+#endif
+
+#if PACKED_GENES
+
 /** 
- * This function generates a new population from a previous one. It does this by selecting and crossing
- * some individuals and applying mutation over some of them. In the and, it updates the current population
- * by the newer one.
+ * This function reads a packed gene (see GET_GENE).
  *
- * @param evaluation A vector that stores the fitness values of the individuals.
- * @param population A vector containing the individuals.
- * @param The index of the best individual in the population after the generation of the new population.
+ * @param bytes A vector of packed genes.
+ * @param bit The position of the first bit of the gene.
+ * @return The gene.
  */
-void newPopulationFM(fitness_t evaluation[], chromosome_t population[][DIMENSION], popsize_t iBest)
+chromosome_t readGeneFM(population_t bytes[], uint16_t bit)
 {
-	chromosome_t newPopulation[NODE_POPULATION_SIZE][DIMENSION];
+	chromosome_t value;
+	uint8_t shift, n;
 	
-	selectionCrossoverProcessing(evaluation, population, newPopulation);
+	bytes += bit / 8;
+	shift = bit % 8;
 	
-	/* Applies the mutation over some individuals */
-	mutationFM(newPopulation);
+	/* The gene starts in the middle of a byte and takes the next ones until it is complete. */
+	value = bytes[0] >> shift;
+	for(n = 8 - shift; n < CHROMOSOME_SIZE; n += 8)
+	{
+		bytes++;
+		value |= (chromosome_t) bytes[0] << n;
+	}
 	
-	/* Replaces the old population by the new one */
-	updateFM(population, newPopulation, iBest);
+	return value & GENE_MAX;
 }
 
 /** 
- * This function mutates some individuals of the population.
+ * This function writes a packed gene (see SET_GENE). The other bits of the vector are kept.
  *
- * @param newPopulation A vector containing the individuals.
+ * @param bytes A vector of packed genes.
+ * @param bit The position of the first bit of the gene.
+ * @param value The gene (it must fit in CHROMOSOME_SIZE bits).
  */
-void mutationFM(chromosome_t newPopulation[][DIMENSION])
+void writeGeneFM(population_t bytes[], uint16_t bit, chromosome_t value)
 {
-	popsize_t i;
-	dimensionsize_t j;
-	chromosomesize_t bitPosition;
+	uint8_t shift, width, mask, n;
 	
-	/* The best individual will not be mutated */
-	for(i = 1; i <=  NODE_MUTATED_INDIVIDUALS; i++)
+	bytes += bit / 8;
+	shift = bit % 8;
+	
+	for(n = 0; n < CHROMOSOME_SIZE; n += width)
 	{
-		
-		for(j = 0; j < DIMENSION; j++)
+		/* Bits of the gene that go in this byte. */
+		width = 8 - shift;
+		if(width > CHROMOSOME_SIZE - n)
 		{
-			bitPosition = lfsr_rand8() & (CHROMOSOME_SIZE-1);	
-			
-#if CHROMOSOME_SIZE == 32
-			if(bitPosition < 8) /* First byte. */
-			{
-				newPopulation[i][j] = newPopulation[i][j] ^ (0x00000001 << bitPosition);
-			}
-			else if (bitPosition < 16) /* Second byte. */
-			{
-				newPopulation[i][j] = newPopulation[i][j] ^ (0x00000100 << (bitPosition - 8));
-			}
-			else if (bitPosition < 24) /* Third byte. */
-			{
-				newPopulation[i][j] = newPopulation[i][j] ^ (0x00010000 << (bitPosition - 16));
-			}
-			else /* Fourth byte. */
-			{
-				newPopulation[i][j] = newPopulation[i][j] ^ (0x01000000 << (bitPosition - 24));
-			}
-#elif CHROMOSOME_SIZE == 16
-			if(bitPosition < 8) /* First byte. */
-			{
-				newPopulation[i][j] = newPopulation[i][j] ^ (0x0001 << bitPosition);
-			}
-			else /* Second byte. */
-			{
-				newPopulation[i][j] = newPopulation[i][j] ^ (0x0100 << (bitPosition - 8));
-			}
-#else	
-			newPopulation[i][j] = newPopulation[i][j] ^ (0x01 << bitPosition);
-#endif
+			width = CHROMOSOME_SIZE - n;
 		}
+		mask = ((1 << width) - 1) << shift;
+		
+		bytes[0] = (bytes[0] & ~mask) | (((uint8_t) (value >> n) << shift) & mask);
+		bytes++;
+		shift = 0;
 	}
 }
 
 /** 
- * This function replaced the old population by the new one.
+ * This function packs the genes of an individual in a vector of bytes (the unused bits are cleared).
  *
- * @param population A vector containing the old individuals.
- * @param newPopulation A vector containing the new individuals.
- * @param iBest The index of the best individual in the population.
+ * @param x A vector containing the genes.
+ * @param packed A vector that will store the INDIVIDUAL_BYTES bytes.
  */
-void updateFM(chromosome_t population[][DIMENSION], chromosome_t newPopulation[][DIMENSION], popsize_t iBest)
+void packIndividualFM(chromosome_t x[], population_t packed[])
 {
-	popsize_t i;
 	dimensionsize_t j;
-	/* Put the best individual of the new population in the first position of the old population. */
+	
+	packed[INDIVIDUAL_BYTES - 1] = 0;
 	for(j = 0; j < DIMENSION; j++)
 	{
-		population[0][j] = population[iBest][j];
+		writeGeneFM(packed, (uint16_t) j * CHROMOSOME_SIZE, x[j]);
 	}
+}
+
+/** 
+ * This function unpacks the genes of an individual from a vector of bytes.
+ *
+ * @param packed A vector containing the INDIVIDUAL_BYTES bytes.
+ * @param x A vector that will store the genes.
+ */
+void unpackIndividualFM(population_t packed[], chromosome_t x[])
+{
+	dimensionsize_t j;
 	
-	/* Replace the old population by the new one */
-	for(i = 1; i < NODE_POPULATION_SIZE; i++)
+	for(j = 0; j < DIMENSION; j++)
 	{
-		for(j = 0; j < DIMENSION; j++)
-		{
-			population[i][j] = newPopulation[i][j];
-		}
+		x[j] = readGeneFM(packed, (uint16_t) j * CHROMOSOME_SIZE);
 	}
 }
 
+#endif
+
+#if WARM_START
+
 /** 
- * This function transfer one individual from slave to master.
+ * This function reseeds the population from the final population of the previous run. The elites
+ * keep their positions (their cells in CELLULAR mode) and the last WARM_IMMIGRANTS other individuals
+ * are replaced by random ones, so the population can follow an objective that drifted.
  *
- * @param x A vector representing a multi-dimension individual.
- * @param nodeId The id of the node to collect the individual from.
- * @param index The index of the individual to be collected.
+ * @param population A vector containing the individuals of the previous run.
  */
-void collectIndividualFM(chromosome_t x[], slave_t  nodeId, popsize_t index)
+void warmStartFM(population_t population[][POPULATION_COLUMNS])
 {
-	dimensionsize_t j;
-	slave_select_t ss;
-	spi_data_t data;
-		
-	/* Define ss based on nodeId. */
-	ss = 3 - nodeId;
+	popsize_t i;
+	popsize_t n;
 	
-	/* Enable the selected slave */
-	while(1)
+	/* eliteIndex still points to the elites of the previous run. */
+	for(i = nodePopulationSize, n = 0; i > 0 && n < WARM_IMMIGRANTS; )
 	{
-		PORTB &= !(1 << ss);
-		
-		/* Send command and receive a response. */
-		SPDR = CMD_COLLECT_IND;
-		while(!(SPSR & (1 << SPIF)));
-		data = SPDR;
-		
-		_delay_ms(1);
-		SPDR = DUMMY;
-		while(!(SPSR & (1 << SPIF)));
-		data = SPDR;
-		
-		PORTB |= (1 << ss);
-		
-		/* Check if it received a ACK. */
-		if(data == ACK_COLLECT_IND)
+		i--;
+		if(!isEliteFM(i))
 		{
-			break;
+			randomIndividualFM(population, i);
+			n++;
 		}
 	}
-	
-	/* Now, send index. */
-	_delay_ms(1);
-	PORTB &= !(1 << ss);
-	
-	SPDR = index;
-	while(!(SPSR & (1 << SPIF)));
-	/* Read dummy data. */
-	data = SPDR;
-	_delay_ms(1);
-	/* Now receive the individual. */
-	
-#if CHROMOSOME_SIZE == 8
+}
 
-	for(j = 0; j < DIMENSION; j++)
-	{
-		SPDR = DUMMY;
-		while(!(SPSR & (1 << SPIF)));
-		x[j] = SPDR;
-	}
-	
-#elif CHROMOSOME_SIZE == 16
+#endif
 
-	chromosome16_bytes temp;
-	dimensionsize_t k;
-	
-	for(j = 0; j < DIMENSION; j++)
+/** 
+ * This function calculates the fitness value for the whole population. Before that, the
+ * individuals are normalized to a range where the solution might be in. It also finds the
+ * ELITES best individuals in the same pass.
+ *
+ * @param evaluation A vector that will store the fitness values for the individuals.
+ * @param population A vector containing the individuals.
+ * @param first The index of the first individual to be evaluated (the ones before it are elites whose fitness is known).
+ * In CELLULAR mode, the elites keep their cells, so any value above 0 only skips the cells of the elites.
+ * @return The index of the best individual in the population after the last generation.
+ */
+popsize_t fitnessFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], popsize_t first)
+{
+#if GA_MODE == GA_MODE_MASTER_WORKER && NODE_ID == 0
+
+	popsize_t next;
+	popsize_t batchFirst[NUM_NODES];
+	popsize_t batchCount[NUM_NODES];
+	slave_t k;
+
+	for(next = first; next < nodePopulationSize; )
 	{
-		_delay_ms(1);
-		for(k = 0; k < 2; k++)
+		/* Hand one batch to each worker... */
+		for(k = 1; k < NUM_NODES; k++)
 		{
-			SPDR = DUMMY;
-			while(!(SPSR & (1 << SPIF)));
-			temp.bytes[k] = SPDR;
+			batchFirst[k] = next;
+			batchCount[k] = (nodePopulationSize - next < EVALUATION_BATCH_SIZE) ? nodePopulationSize - next : EVALUATION_BATCH_SIZE;
+			next += batchCount[k];
+			
+			/* If the worker does not answer, the master evaluates the batch itself. */
+			if(batchCount[k] > 0 && !sendBatchFM(population, batchFirst[k], batchCount[k], k))
+			{
+				evaluateRangeFM(evaluation, population, batchFirst[k], batchCount[k]);
+				batchCount[k] = 0;
+			}
 		}
 		
-		x[j] = temp.value;
+		/* ...evaluate one locally while they work... */
+		batchFirst[0] = next;
+		batchCount[0] = (nodePopulationSize - next < EVALUATION_BATCH_SIZE) ? nodePopulationSize - next : EVALUATION_BATCH_SIZE;
+		next += batchCount[0];
+		evaluateRangeFM(evaluation, population, batchFirst[0], batchCount[0]);
+		
+		/* ...and then collect their results. */
+		for(k = 1; k < NUM_NODES; k++)
+		{
+			if(batchCount[k] > 0 && !collectBatchFM(&evaluation[batchFirst[k]], batchCount[k], k))
+			{
+				evaluateRangeFM(evaluation, population, batchFirst[k], batchCount[k]);
+			}
+		}
 	}
 	
-#else
-	chromosome32_bytes temp;
-	dimensionsize_t k;
+#elif CELLULAR
+
+	popsize_t i;
 	
-	for(j = 0; j < DIMENSION; j++)
+	for(i = 0; i < nodePopulationSize; i++)
 	{
-		_delay_ms(1);
-		for(k = 0; k < 4; k++)
+		if(first == 0 || !isEliteFM(i))
 		{
-			SPDR = DUMMY;
-			while(!(SPSR & (1 << SPIF)));
-			temp.bytes[k] = SPDR;
+			evaluateRangeFM(evaluation, population, i, 1);
 		}
-		
-		x[j] = temp.value;
 	}
 
-#endif	
-
-	/* Disable the selected slave */
-	PORTB |= (1 << ss);
-}
+#else
 
+	evaluateRangeFM(evaluation, population, first, nodePopulationSize - first);
 
+#endif
+	
+	return elitesFM(evaluation);
+}
 
 /** 
- * This function transfer the evaluation of a individual from slave to master.
+ * This function finds the ELITES best individuals of the population from their fitness values.
  *
- * @param nodeId The id of the node to collect the fitness value.
- * @param index The index of the fitness value to be collected.
- * @returns The fitness value collected.
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ * @return The index of the best individual in the population.
  */
-float collectEvaluationFM(slave_t nodeId, popsize_t index)
+popsize_t elitesFM(fitness_t evaluation[])
 {
-	slave_select_t ss;
-	dimensionsize_t b;
-	float_bytes received;
-	spi_data_t data;
-	
-	/* Define ss based on nodeId. */
-	ss = 3 - nodeId;
+	popsize_t i;
+	uint8_t count, e, m;
 	
-	while(1)
+	/* Keep the ELITES best individuals sorted, each one enters the list by insertion. */
+	for (i = 0, count = 0; i < nodePopulationSize; i++)
 	{
-		
-		/* Enable the selected slave */
-		PORTB &= !(1 << ss);
-		
-		/* Send command and receive a response. */
-		SPDR = CMD_COLLECT_EV;
-		while(!(SPSR & (1 << SPIF)));		
-		data = SPDR;
-		
-		_delay_ms(1);
-		SPDR = DUMMY;
-		while(!(SPSR & (1 << SPIF)));
-		data = SPDR;
-		
-		/* Disable the selected slave */
-		PORTB |= (1 << ss);
-		
-		/* Check if it received a ACK. */
-		if(data == ACK_COLLECT_EV)
+		e = elitePositionFM(eliteFitness, count, evaluation[i]);
+		if (e < ELITES)
 		{
-			break;
-		}
-		
+			if (count < ELITES)
+			{
+				count++;
+			}
+			for (m = count - 1; m > e; m--)
+			{
+				eliteIndex[m] = eliteIndex[m - 1];
+				eliteFitness[m] = eliteFitness[m - 1];
+			}
+			eliteIndex[e] = i;
+			eliteFitness[e] = evaluation[i];
+		}	
 	}
+
+	return eliteIndex[0];
+}
+
+/** 
+ * This function finds where a fitness value enters a list of the best ones, sorted from the best
+ * one. A value equal to others goes after them.
+ *
+ * @param best A vector with the fitness values of the list.
+ * @param count The number of values in the list (up to ELITES).
+ * @param value The fitness value.
+ * @return The position of the value or ELITES if it does not enter a full list.
+ */
+uint8_t elitePositionFM(fitness_t best[], uint8_t count, fitness_t value)
+{
+	uint8_t e;
 	
-	/* Now, send index. */
-	_delay_ms(1);
-	/* Enable the selected slave */
-	PORTB &= !(1 << ss);
-	SPDR = index;
-	while(!(SPSR & (1 << SPIF)));
-	/* Read dummy data. */
-	data = SPDR;
-	
-	_delay_ms(1);
-	/* Now receive the 4 bytes. */
-	for(b = 0; b < sizeof(float); b++)
+	if (count == ELITES && !(value < best[ELITES - 1]))
 	{
-		SPDR = DUMMY;
-		while(!(SPSR & (1 << SPIF)));
-		received.bytes[b] = SPDR;
+		return ELITES;
 	}
 	
-	/* Disable the selected slave */
-	PORTB |= (1 << ss);
+	for (e = count; e > 0 && value < best[e - 1]; e--);
 	
-	return received.value;
+	return e;
 }
 
+#if CELLULAR || WARM_START
+
 /** 
- * This function transfer one individual from master to slave.
- * It will be stored in the next available position.
- * @param x A vector representing a multi-dimension individual.
- * @param nodeId The id of the node to collect the individual from.
+ * This function checks if a position (a cell in CELLULAR mode) holds one of the elites of this node.
+ *
+ * @param i The index of the position.
+ * @return 1 if the position holds an elite or 0 otherwise.
  */
-void sendIndividualFM(chromosome_t x[], slave_t nodeId)
+uint8_t isEliteFM(popsize_t i)
 {
-	dimensionsize_t j;
-	slave_select_t ss;
-	spi_data_t data;
-	
-	/* Define ss based on nodeId. */
-	ss = 3 - nodeId;
+	uint8_t e;
 	
-	/* Enable the selected slave */
-	
-	while(1)
+	for(e = 0; e < ELITES; e++)
 	{
-		
-		PORTB &= !(1 << ss);
-		
-		/* Send command and receive a response. */
-		SPDR = CMD_SEND_IND;
-		while(!(SPSR & (1 << SPIF)));
-		data = SPDR;
-		
-		_delay_ms(1);
-		SPDR = DUMMY;
-		while(!(SPSR & (1 << SPIF)));
-		data = SPDR;
-		
-		PORTB |= (1 << ss);
-		
-		/* Check if it received a ACK. */
-		if(data == ACK_SEND_IND)
+		if(eliteIndex[e] == i)
 		{
-			break;
+			return 1;
 		}
-		
 	}
 	
-	_delay_ms(1);
-	/* Now send the individual. */
-	PORTB &= !(1 << ss);
+	return 0;
+}
+
+#endif
+
+/** 
+ * This function normalizes and evaluates a range of individuals.
+ *
+ * @param evaluation A vector that will store the fitness values for the individuals.
+ * @param population A vector containing the individuals.
+ * @param first The index of the first individual to be evaluated.
+ * @param count The number of individuals to be evaluated.
+ */
+void evaluateRangeFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], popsize_t first, popsize_t count)
+{
+	popsize_t i;
+	normalization_t normalizedChromosome[DIMENSION];
+#if INDIVIDUAL_COPY
+	chromosome_t x[DIMENSION];
+#endif
 	
-#if CHROMOSOME_SIZE == 8
+	for (i = first; i < first + count; i++)
+	{
+		/* First, normalize the individual */
+		normalizationFM(INDIVIDUAL(population, i, x), normalizedChromosome);
+				
+		/* The evaluation function (evaluationFM) must be defined by the user */
+		evaluation[i] = evaluationFM(normalizedChromosome); 
+	}
+}
 
+/** 
+ * This function normalizes an individual to an specified range (between NORMALIZATION_MIN and NORMALIZATION_MAX).
+ *
+ * @param chromesome A individual of the population.
+ * @param normalizedChromesome The normalized individual.
+ */
+void normalizationFM(chromosome_t chromesome[], normalization_t normalizedChromesome[])
+{
+	dimensionsize_t j;
 	for(j = 0; j < DIMENSION; j++)
 	{
-		SPDR = x[j];
-		while(!(SPSR & (1 << SPIF)));
-		data = SPDR;
+	    /* Applies a normalized gain on the chromosome */
+		normalizedChromesome[j] = NORMALIZATION_MIN + ((normalization_t) NORMALIZED_GAIN) * chromesome[j];
 	}
 
-#elif CHROMOSOME_SIZE == 16
+}
 
-	chromosome16_bytes temp;
-	dimensionsize_t k;
+/** 
+ * This function generates a new population from a previous one. It does this by selecting and crossing
+ * some individuals and applying mutation over some of them. In the and, it updates the current population
+ * by the newer one.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ * @param population A vector containing the individuals.
+ */
+void newPopulationFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS])
+{
+#if GA_MODE == GA_MODE_PARTITIONED || NODE_ID == 0 /* Workers never generate populations. */
+	population_t newPopulation[POPULATION_ROWS][POPULATION_COLUMNS];
 	
-	for(j = 0; j < DIMENSION; j++)
+#if BROADCAST_SELECT && GA_MODE == GA_MODE_PARTITIONED && NODE_ID == 0
+	/* Wait for the slaves that are still evaluating, so the handshakes do not have to poll them. */
+	if(slavesAliveFM())
 	{
-		temp.value = x[j];
-		_delay_ms(1);
-		for(k = 0; k < 2; k++)
-		{
-			SPDR = temp.bytes[k];
-			while(!(SPSR & (1 << SPIF)));
-			data = SPDR; // Clean up the buffer.
-		}
-	}	
+		slavesReadyFM(HANDSHAKE_TIMEOUT_MS);
+	}
+#endif
 	
-#else
-
-	chromosome32_bytes temp;
-	dimensionsize_t k;
+	selectionCrossoverProcessing(evaluation, population, newPopulation);
 	
-	for(j = 0; j < DIMENSION; j++)
-	{
-		temp.value = x[j];
-		_delay_ms(1);
-		for(k = 0; k < 4; k++)
-		{
-			SPDR = temp.bytes[k];
-			while(!(SPSR & (1 << SPIF)));
-			data = SPDR; // Clean up the buffer.
-		}
-	}
-
+#if CELLULAR
+	/* The halo arrived, so each node breeds its own rows of the grid. */
+	cellularSelectionFM(evaluation, population, newPopulation);
 #endif
-
 	
-	/* Disable the selected slave */
-	PORTB |= (1 << ss);
+	/* Applies the mutation over some individuals */
+	mutationFM(newPopulation);
 	
+	/* Replaces the old population by the new one */
+	updateFM(evaluation, population, newPopulation);
+#else
+	(void) evaluation;
+	(void) population;
+#endif
 }
 
-#if NODE_ID == 0
+#if MUTATION_SKIP
 
-void collectBestIndividualsFM(chromosome_t bestIndividuals[][DIMENSION], chromosome_t population[][DIMENSION], popsize_t iBest)
+/** 
+ * This function mutates some individuals of the population.
+ *
+ * @param newPopulation A vector containing the individuals.
+ */
+void mutationFM(population_t newPopulation[][POPULATION_COLUMNS])
 {
 	popsize_t i;
 	dimensionsize_t j;
-	slave_select_t ss;
-	spi_data_t data;
+	uint32_t offset;
+	uint32_t limit;
+	uint16_t bit;
 	
-	/* Grab the best from the master. */
-	for(j = 0; j < DIMENSION; j++)
-	{
-		bestIndividuals[iBest][j] = population[0][j];
-	}
+	/* The bits of the individuals ELITES to nodePopulationSize - 1 are numbered one after the other (the
+	elites will not be mutated), and only the flipped ones are visited. In CELLULAR mode, the elites keep
+	their cells, so all individuals are numbered and the bits of the elites are not flipped. */
+#if CELLULAR
+	limit = (uint32_t) nodePopulationSize * INDIVIDUAL_BITS;
+	i = 0;
+#else
+	limit = (uint32_t) (nodePopulationSize - ELITES) * INDIVIDUAL_BITS;
+	i = ELITES;
+#endif
+	offset = mutationGapFM(limit);
 	
-	/* Collect the best from the other slaves. */
-	for(i = 1; i < NUM_NODES; i++)
+	while(1)
 	{
-		//collectIndividualFM(bestIndividuals[i], i, 0);
-		
-		/* Define ss based on nodeId. */
-		ss = 3 - i;
-		
-		/* Enable the selected slave */
-		while(1)
-		{					
-			/* Send command and receive a response. */
-			PORTB &= !(1 << ss);
-			
-			SPDR = CMD_COLLECT_BEST_IND;
-			while(!(SPSR & (1 << SPIF)));
-			data = SPDR;
-			
-			_delay_ms(1);
-
-			SPDR = DUMMY;
-			while(!(SPSR & (1 << SPIF)));
-			data = SPDR;
-			
-			PORTB |= (1 << ss);	
-		
-			_delay_ms(1);
-						
-			/* Check if it received a ACK. */
-			if(data == ACK_COLLECT_BEST_IND)
+		/* Skip to the individual of the bit, offset is the position inside it. */
+		while(offset >= INDIVIDUAL_BITS)
+		{
+			offset -= INDIVIDUAL_BITS;
+			if(++i >= nodePopulationSize)
 			{
-				break;
+				return;
 			}
 		}
 		
-		/* Now receive the individual. */
-#if CHROMOSOME_SIZE == 8
-
-		for(j = 0; j < DIMENSION; j++)
+		bit = (uint16_t) offset;
+		j = bit / CHROMOSOME_SIZE;
+#if CELLULAR
+		if(!isEliteFM(i))
+#endif
 		{
-			PORTB &= !(1 << ss);
-			SPDR = DUMMY;
-			while(!(SPSR & (1 << SPIF)));
-			PORTB |= (1 << ss);	
-			bestIndividuals[i][j] = SPDR;
+			SET_GENE(newPopulation, i, j, GET_GENE(newPopulation, i, j) ^ ((chromosome_t) 1 << (bit % CHROMOSOME_SIZE)));
 		}
+		
+		offset += 1 + mutationGapFM(limit);
+	}
+}
+
+/** 
+ * This function fills the tables used by mutationGapFM. A gap G between flipped bits follows a
+ * geometric distribution, which is split as G = MUTATION_TABLE * Q + R: Q (full chunks of bits) and
+ * R (bits in the last chunk) are drawn from the cumulative distributions stored in the tables.
+ */
+void mutationTableFM(void)
+{
+	uint8_t g;
+	float q, chunk, cdf;
+	
+	/* Probability of keeping a bit and a whole chunk. */
+	q = 1.0 - MUTATION_RATE;
+	chunk = pow(q, MUTATION_TABLE);
 	
-#elif CHROMOSOME_SIZE == 16
+	for(g = 0; g < MUTATION_TABLE; g++)
+	{
+		/* P(Q <= g), Q only goes beyond the table with probability chunk^MUTATION_TABLE. */
+		cdf = 1.0 - pow(chunk, g + 1);
+		chunkThreshold[g] = (cdf < 65535.0 / 65536.0) ? (uint16_t) (cdf * 65536.0 + 0.5) : 65535;
+		
+		/* P(R <= g), R is always inside the chunk. */
+		cdf = (1.0 - pow(q, g + 1)) / (1.0 - chunk);
+		bitThreshold[g] = (cdf < 65535.0 / 65536.0) ? (uint16_t) (cdf * 65536.0 + 0.5) : 65535;
+	}
+}
 
-		chromosome16_bytes temp;
-		dimensionsize_t k;
+/** 
+ * This function finds the first entry of a table above a random number.
+ *
+ * @param table A cumulative distribution (MUTATION_TABLE entries).
+ * @param u A random number.
+ * @return The index of the entry (MUTATION_TABLE if u is above all entries).
+ */
+uint8_t mutationSearchFM(uint16_t table[], uint16_t u)
+{
+	uint8_t g, step;
 	
-		for(j = 0; j < DIMENSION; j++)
+	g = 0;
+	for(step = MUTATION_TABLE / 2; step > 0; step >>= 1)
+	{
+		if(u >= table[g + step - 1])
 		{
-			_delay_ms(1);
-			for(k = 0; k < 2; k++)
-			{
-				PORTB &= !(1 << ss);
-				SPDR = DUMMY;
-				while(!(SPSR & (1 << SPIF)));
-				PORTB |= (1 << ss);	
-				temp.bytes[k] = SPDR;
-			}
-		
-			bestIndividuals[i][j] = temp.value;
+			g += step;
 		}
+	}
 	
-#else
-		chromosome32_bytes temp;
-		dimensionsize_t k;
+	return (u < table[g]) ? g : MUTATION_TABLE;
+}
+
+/** 
+ * This function draws the number of bits skipped before the next flipped bit.
+ *
+ * @param limit The gap is not drawn further than this number of bits.
+ * @return The number of bits to skip (at least limit if the next flipped bit is beyond it).
+ */
+uint32_t mutationGapFM(uint32_t limit)
+{
+	uint32_t gap;
+	uint8_t g;
 	
-		for(j = 0; j < DIMENSION; j++)
+	/* The distribution has no memory, so when Q is beyond the table, skip its chunks and draw again. */
+	gap = 0;
+	while((g = mutationSearchFM(chunkThreshold, random16())) == MUTATION_TABLE)
+	{
+		gap += (uint16_t) MUTATION_TABLE * MUTATION_TABLE;
+		if(gap >= limit)
 		{
-			_delay_ms(1);
-			for(k = 0; k < 4; k++)
-			{
-				PORTB &= !(1 << ss);
-				SPDR = DUMMY;
-				while(!(SPSR & (1 << SPIF)));
-				PORTB |= (1 << ss);	
-				temp.bytes[k] = SPDR;
-			}
-		
-			bestIndividuals[i][j] = temp.value;
+			return gap;
 		}
-
-#endif
 	}
+	gap += (uint16_t) g * MUTATION_TABLE;
+	
+	g = mutationSearchFM(bitThreshold, random16());
+	
+	return gap + ((g < MUTATION_TABLE) ? g : MUTATION_TABLE - 1);
 }
 
+#else
 
-/* This function is run only by the master. It controls the selection and crossover of all nodes. */
-void selectionCrossoverProcessing(fitness_t evaluation[], chromosome_t population[][DIMENSION], chromosome_t newPopulation[][DIMENSION])
+/** 
+ * This function mutates some individuals of the population.
+ *
+ * @param newPopulation A vector containing the individuals.
+ */
+void mutationFM(population_t newPopulation[][POPULATION_COLUMNS])
 {
-	// popsize_t internalCounter = 0;
-	popsize_t iChromosomeX1, iChromosomeX2, iChromosomeY1, iChromosomeY2, iWinnerX, iWinnerY;
-	fitness_t fitnessX1, fitnessX2, fitnessY1, fitnessY2;
-	slave_t nodeChromosomeX1, nodeChromosomeX2, nodeChromosomeY1, nodeChromosomeY2, nodeWinnerX, nodeWinnerY;
-	chromosome_t winnerX[DIMENSION], winnerY[DIMENSION], newIndX[DIMENSION], newIndY[DIMENSION];
-	popsize_t i;
+	/* With more nodes than MUTATED_INDIVIDUALS, no node mutates. */
+#if NODE_MUTATED_INDIVIDUALS > 0
+	popsize_t i, m;
 	dimensionsize_t j;
+	chromosomesize_t bitPosition;
 	
-	for(i = 0; i < POPULATION_SIZE; i += 2) /* Process the whole population. */
+	/* The elites will not be mutated */
+	for(m = 0; m < NODE_MUTATED_INDIVIDUALS; m++)
 	{
-		/* Randomly pick 4 individuals (2 winners to generate 2 new individuals). */
-		
-#if POPULATION_SIZE < 256
-		iChromosomeX1 = lfsr_rand8() & (POPULATION_SIZE - 1);
-		iChromosomeX2 = lfsr_rand8() & (POPULATION_SIZE - 1);
-		iChromosomeY1 = lfsr_rand8() & (POPULATION_SIZE - 1);
-		iChromosomeY2 = lfsr_rand8() & (POPULATION_SIZE - 1);
-#else
-		iChromosomeX1 = lfsr_rand16() & (POPULATION_SIZE - 1);
-		iChromosomeX2 = lfsr_rand16() & (POPULATION_SIZE - 1);
-		iChromosomeY1 = lfsr_rand16() & (POPULATION_SIZE - 1);
-		iChromosomeY2 = lfsr_rand16() & (POPULATION_SIZE - 1);
-#endif		
+#if CELLULAR
+		/* The position of a cell matters in the grid, so the mutated ones are picked at random (the
+		elites keep their cells). */
+		do
+		{
+			i = ((uint16_t) random8() * nodePopulationSize) >> 8;
+		}
+		while(isEliteFM(i));
+#else
+		i = ELITES + m;
+#endif
+		
+		for(j = 0; j < DIMENSION; j++)
+		{
+#if CHROMOSOME_SIZE & (CHROMOSOME_SIZE - 1)
+			bitPosition = ((uint16_t) random8() * CHROMOSOME_SIZE) >> 8;
+#else
+			bitPosition = random8() & (CHROMOSOME_SIZE-1);	
+#endif
+			
+#if CHROMOSOME_SIZE > 16
+			if(bitPosition < 8) /* First byte. */
+			{
+				SET_GENE(newPopulation, i, j, GET_GENE(newPopulation, i, j) ^ (0x00000001 << bitPosition));
+			}
+			else if (bitPosition < 16) /* Second byte. */
+			{
+				SET_GENE(newPopulation, i, j, GET_GENE(newPopulation, i, j) ^ (0x00000100 << (bitPosition - 8)));
+			}
+			else if (bitPosition < 24) /* Third byte. */
+			{
+				SET_GENE(newPopulation, i, j, GET_GENE(newPopulation, i, j) ^ (0x00010000 << (bitPosition - 16)));
+			}
+			else /* Fourth byte. */
+			{
+				SET_GENE(newPopulation, i, j, GET_GENE(newPopulation, i, j) ^ (0x01000000 << (bitPosition - 24)));
+			}
+#elif CHROMOSOME_SIZE > 8
+			if(bitPosition < 8) /* First byte. */
+			{
+				SET_GENE(newPopulation, i, j, GET_GENE(newPopulation, i, j) ^ (0x0001 << bitPosition));
+			}
+			else /* Second byte. */
+			{
+				SET_GENE(newPopulation, i, j, GET_GENE(newPopulation, i, j) ^ (0x0100 << (bitPosition - 8)));
+			}
+#else	
+			SET_GENE(newPopulation, i, j, GET_GENE(newPopulation, i, j) ^ (0x01 << bitPosition));
+#endif
+		}
+	}
+#else
+	(void) newPopulation;
+#endif
+}
+
+#endif
+
+/** 
+ * This function replaced the old population by the new one. The elites of the old population are
+ * kept in the first positions (in their own cells in CELLULAR mode), along with their fitness values.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ * @param population A vector containing the old individuals.
+ * @param newPopulation A vector containing the new individuals.
+ */
+void updateFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], population_t newPopulation[][POPULATION_COLUMNS])
+{
+	popsize_t i;
+	dimensionsize_t j;
+#if !CELLULAR
+	uint8_t e;
+	
+	/* Put the elites of the old population in the first positions of the new one (the elites can be
+	in any position of the old population, so they are not copied over it directly). In CELLULAR mode,
+	cellularSelectionFM already left them in their cells, along with their fitness values. */
+	for(e = 0; e < ELITES; e++)
+	{
+		for(j = 0; j < DIMENSION; j++)
+		{
+			SET_GENE(newPopulation, e, j, GET_GENE(population, eliteIndex[e], j));
+		}
+		evaluation[e] = eliteFitness[e];
+		eliteIndex[e] = e;
+	}
+#endif
+	
+	/* Replace the old population by the new one */
+#if PACKED_GENES
+	for(i = 0; i < nodePopulationSize; i++)
+	{
+		for(j = 0; j < DIMENSION; j++)
+		{
+			SET_GENE(population, i, j, GET_GENE(newPopulation, i, j));
+		}
+	}
+#elif POPULATION_LAYOUT == LAYOUT_SOA
+	for(j = 0; j < DIMENSION; j++)
+	{
+		for(i = 0; i < nodePopulationSize; i++)
+		{
+			population[j][i] = newPopulation[j][i];
+		}
+	}
+#else
+	for(i = 0; i < nodePopulationSize; i++)
+	{
+		for(j = 0; j < DIMENSION; j++)
+		{
+			population[i][j] = newPopulation[i][j];
+		}
+	}
+#endif
+}
+
+#if STEADY_STATE
+
+/** 
+ * This function runs one step of the steady-state GA. The master creates STEADY_OFFSPRING new
+ * individuals and hands them to the nodes, and then each node evaluates only the ones it got.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ * @param population A vector containing the individuals.
+ */
+void steadyStateFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS])
+{
+	offspringCount = 0;
+	
+#if NODE_ID == 0
+#if BROADCAST_SELECT
+	/* Wait for the slaves that are still evaluating, so the handshakes do not have to poll them. */
+	if(slavesAliveFM())
+	{
+		slavesReadyFM(HANDSHAKE_TIMEOUT_MS);
+	}
+#endif
+	steadySelectionFM(evaluation, population);
+#else
+	/* The slaves answer the same commands of a generation, their new individuals go to offspring. */
+	selectionCrossoverProcessing(evaluation, population, population);
+#endif
+	
+	replaceWorstFM(evaluation, population);
+}
+
+/** 
+ * This function evaluates the new individuals this node got in the current step. Each one replaces
+ * the worst individual of the node if it is better.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ * @param population A vector containing the individuals.
+ */
+void replaceWorstFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS])
+{
+	normalization_t normalizedChromosome[DIMENSION];
+	fitness_t fitnessValue;
+	popsize_t i;
+	dimensionsize_t j;
+	uint8_t c;
+	
+	for(c = 0; c < offspringCount; c++)
+	{
+		normalizationFM(offspring[c], normalizedChromosome);
+		fitnessValue = evaluationFM(normalizedChromosome);
+		
+		/* The worst individual is on top of the heap, so only its entry has to move down. */
+		i = worstHeap[0];
+		if(fitnessValue < evaluation[i])
+		{
+			for(j = 0; j < DIMENSION; j++)
+			{
+				SET_GENE(population, i, j, offspring[c][j]);
+			}
+			evaluation[i] = fitnessValue;
+			worstSiftFM(evaluation, 0);
+		}
+	}
+}
+
+/** 
+ * This function builds the heap of the individuals of this node, the worst one on top.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ */
+void worstHeapFM(fitness_t evaluation[])
+{
+	popsize_t h;
+	
+	for(h = 0; h < nodePopulationSize; h++)
+	{
+		worstHeap[h] = h;
+	}
+	
+	for(h = nodePopulationSize / 2; h > 0; h--)
+	{
+		worstSiftFM(evaluation, h - 1);
+	}
+}
+
+/** 
+ * This function moves an entry of the heap down until the entries below it are not worse.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ * @param h The position of the entry in the heap.
+ */
+void worstSiftFM(fitness_t evaluation[], popsize_t h)
+{
+	popsize_t i;
+	uint16_t child;
+	
+	i = worstHeap[h];
+	while((child = 2 * (uint16_t) h + 1) < nodePopulationSize)
+	{
+		/* Follow the worst child. */
+		if(child + 1 < nodePopulationSize && evaluation[worstHeap[child + 1]] > evaluation[worstHeap[child]])
+		{
+			child++;
+		}
+		
+		if(!(evaluation[worstHeap[child]] > evaluation[i]))
+		{
+			break;
+		}
+		
+		worstHeap[h] = worstHeap[child];
+		h = child;
+	}
+	worstHeap[h] = i;
+}
+
+#endif
+
+#if STEADY_STATE || CELLULAR
+
+/** 
+ * This function changes the number of individuals of this node. The new positions start with random
+ * individuals marked as the worst ones, so they are the first to be replaced.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ * @param population A vector containing the individuals.
+ * @param size The new number of individuals.
+ */
+void resizePartitionFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], popsize_t size)
+{
+	popsize_t i;
+	
+	for(i = nodePopulationSize; i < size; i++)
+	{
+		randomIndividualFM(population, i);
+		evaluation[i] = FITNESS_WORST;
+	}
+	nodePopulationSize = size;
+	
+#if STEADY_STATE
+	worstHeapFM(evaluation);
+#endif
+}
+
+#endif
+
+#if CELLULAR
+
+/** 
+ * This function breeds the rows of the grid stored by this node. The parents of each cell are the
+ * winners of two tournaments between random cells of its neighbourhood, and the first individual of
+ * their crossover takes the position of the cell. The elites keep their cells.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ * @param population A vector containing the individuals.
+ * @param newPopulation A vector that will store the new individuals.
+ */
+void cellularSelectionFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], population_t newPopulation[][POPULATION_COLUMNS])
+{
+	popsize_t i;
+	int16_t a, b, x, y;
+	dimensionsize_t j;
+	
+	for(i = 0; i < nodePopulationSize; i++)
+	{
+		if(isEliteFM(i))
+		{
+			for(j = 0; j < DIMENSION; j++)
+			{
+				SET_GENE(newPopulation, i, j, GET_GENE(population, i, j));
+			}
+			continue;
+		}
+		
+		a = cellNeighbourFM(i, ((uint16_t) random8() * CELL_NEIGHBOURS) >> 8);
+		b = cellNeighbourFM(i, ((uint16_t) random8() * CELL_NEIGHBOURS) >> 8);
+		x = (cellFitnessFM(evaluation, a) < cellFitnessFM(evaluation, b)) ? a : b;
+		a = cellNeighbourFM(i, ((uint16_t) random8() * CELL_NEIGHBOURS) >> 8);
+		b = cellNeighbourFM(i, ((uint16_t) random8() * CELL_NEIGHBOURS) >> 8);
+		y = (cellFitnessFM(evaluation, a) < cellFitnessFM(evaluation, b)) ? a : b;
+		
+		for(j = 0; j < DIMENSION; j++)
+		{
+			SET_GENE(newPopulation, i, j, (cellGeneFM(population, x, j) & MASK) | (cellGeneFM(population, y, j) & ~MASK));
+		}
+	}
+}
+
+/** 
+ * This function finds a cell of the neighbourhood of another one. The columns wrap around inside the
+ * node, while the rows above the first one and below the last one are in the halo.
+ *
+ * @param cell The index of the cell.
+ * @param n The neighbour, between 0 and CELL_NEIGHBOURS - 1.
+ * @return The index of the neighbour (from -CELL_WIDTH for the halo above to nodePopulationSize + CELL_WIDTH - 1 for the halo below).
+ */
+int16_t cellNeighbourFM(popsize_t cell, uint8_t n)
+{
+	int16_t row, column;
+	
+	row = cell / CELL_WIDTH + cellRow[n];
+	column = cell % CELL_WIDTH + cellColumn[n];
+	
+	if(column < 0)
+	{
+		column += CELL_WIDTH;
+	}
+	else if(column >= CELL_WIDTH)
+	{
+		column -= CELL_WIDTH;
+	}
+	
+	return row * CELL_WIDTH + column;
+}
+
+/** 
+ * This function gets the fitness value of a cell, which may be in the halo.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ * @param p The index of the cell (see cellNeighbourFM).
+ * @return The fitness value of the cell.
+ */
+fitness_t cellFitnessFM(fitness_t evaluation[], int16_t p)
+{
+	if(p < 0)
+	{
+		return haloFitness[p + CELL_WIDTH];
+	}
+	else if(p >= nodePopulationSize)
+	{
+		return haloFitness[p - nodePopulationSize + CELL_WIDTH];
+	}
+	
+	return evaluation[p];
+}
+
+/** 
+ * This function gets a gene of a cell, which may be in the halo.
+ *
+ * @param population A vector containing the individuals.
+ * @param p The index of the cell (see cellNeighbourFM).
+ * @param j The gene.
+ * @return The gene of the cell.
+ */
+chromosome_t cellGeneFM(population_t population[][POPULATION_COLUMNS], int16_t p, dimensionsize_t j)
+{
+	if(p < 0)
+	{
+		return halo[p + CELL_WIDTH][j];
+	}
+	else if(p >= nodePopulationSize)
+	{
+		return halo[p - nodePopulationSize + CELL_WIDTH][j];
+	}
+	
+	return GET_GENE(population, p, j);
+}
+
+#endif
+
+/** 
+ * This function writes one individual to the SPI, least significant byte first. It is used by the
+ * master to send and by the slaves to answer (in this case the master clocks the bytes). The bytes
+ * received at the same time are stored in a vector (the ones that do not fit follow the individual).
+ *
+ * @param x A vector representing a multi-dimension individual.
+ * @param in A vector that will store the bytes received along with the individual.
+ * @param count The number of bytes to be received (0 to discard them).
+ */
+void spiWriteIndividualFM(chromosome_t x[], spi_data_t in[], uint8_t count)
+{
+	uint16_t b;
+	uint8_t k;
+	spi_data_t data;
+#if PACKED_GENES
+	population_t packed[INDIVIDUAL_BYTES];
+	
+	packIndividualFM(x, packed);
+#endif
+	
+	k = 0;
+	for(b = 0; b < INDIVIDUAL_BYTES; b++)
+	{
+#if NODE_ID == 0
+		if(b % sizeof(chromosome_t) == 0)
+		{
+			power_delay_ms(1);
+		}
+#endif
+#if PACKED_GENES
+		SPDR = packed[b];
+#else
+		SPDR = (spi_data_t) (x[b / sizeof(chromosome_t)] >> (8 * (b % sizeof(chromosome_t))));
+#endif
+		while(!(SPSR & (1 << SPIF)));
+		data = SPDR;
+		if(k < count)
+		{
+			in[k++] = data;
+		}
+	}
+	
+	for(; k < count; k++)
+	{
+		SPDR = DUMMY;
+		while(!(SPSR & (1 << SPIF)));
+		in[k] = SPDR;
+	}
+}
+
+/** 
+ * This function reads one individual from the SPI, least significant byte first. The bytes of a
+ * vector are sent at the same time instead of dummy bytes (the ones that do not fit follow the individual).
+ *
+ * @param x A vector that will store the individual.
+ * @param out A vector containing the bytes to be sent along with the individual.
+ * @param count The number of bytes to be sent (0 to send only dummy bytes).
+ */
+void spiReadIndividualFM(chromosome_t x[], spi_data_t out[], uint8_t count)
+{
+	uint16_t b;
+	uint8_t k;
+#if PACKED_GENES
+	population_t packed[INDIVIDUAL_BYTES];
+#endif
+	
+	k = 0;
+	for(b = 0; b < INDIVIDUAL_BYTES; b++)
+	{
+#if NODE_ID == 0
+		if(b % sizeof(chromosome_t) == 0)
+		{
+			power_delay_ms(1);
+		}
+#endif
+		SPDR = (k < count) ? out[k++] : DUMMY;
+		while(!(SPSR & (1 << SPIF)));
+#if PACKED_GENES
+		packed[b] = SPDR;
+#else
+		if(b % sizeof(chromosome_t) == 0)
+		{
+			x[b / sizeof(chromosome_t)] = 0;
+		}
+		x[b / sizeof(chromosome_t)] |= (chromosome_t) SPDR << (8 * (b % sizeof(chromosome_t)));
+#endif
+	}
+	
+	for(; k < count; k++)
+	{
+		SPDR = out[k];
+		while(!(SPSR & (1 << SPIF)));
+		(void) SPDR;
+	}
+
+#if PACKED_GENES
+	unpackIndividualFM(packed, x);
+#endif
+}
+
+#if CHECKPOINT_INTERVAL
+
+/** 
+ * This function saves the state of this node (random generators, partition and population) in the EEPROM.
+ *
+ * @param population A vector containing the individuals.
+ * @param generation The number of generations already run.
+ */
+void checkpointFM(population_t population[][POPULATION_COLUMNS], generationsize_t generation)
+{
+	random_state state;
+#if POPULATION_LAYOUT == LAYOUT_SOA
+	dimensionsize_t j;
+#endif
+	
+	random_get_state(&state);
+	
+	checkpoint_begin();
+	checkpoint_write(&state, sizeof(state));
+	checkpoint_write(&nodePopulationSize, sizeof(nodePopulationSize));
+#if NODE_ID == 0 && GA_MODE == GA_MODE_PARTITIONED
+	checkpoint_write(populationStart, sizeof(populationStart));
+#endif
+#if POPULATION_LAYOUT == LAYOUT_SOA
+	for(j = 0; j < DIMENSION; j++)
+	{
+		checkpoint_write(population[j], GENE_BYTES(nodePopulationSize));
+	}
+#else
+	checkpoint_write(population, nodePopulationSize * sizeof(population[0]));
+#endif
+	checkpoint_commit(epoch, generation);
+}
+
+/** 
+ * This function restores the state of this node from a checkpoint of the current epoch.
+ *
+ * @param population A vector that will store the individuals.
+ * @param generation The generation of the checkpoint.
+ * @return 1 if the checkpoint was restored or 0 if it was not found.
+ */
+uint8_t resumeFM(population_t population[][POPULATION_COLUMNS], generationsize_t generation)
+{
+	random_state state;
+#if NODE_ID == 0 && GA_MODE == GA_MODE_PARTITIONED
+	slave_t i;
+#endif
+#if POPULATION_LAYOUT == LAYOUT_SOA
+	dimensionsize_t j;
+#endif
+	
+	if(!checkpoint_open(epoch, generation))
+	{
+		return 0;
+	}
+	
+	checkpoint_read(&state, sizeof(state));
+	checkpoint_read(&nodePopulationSize, sizeof(nodePopulationSize));
+#if NODE_ID == 0 && GA_MODE == GA_MODE_PARTITIONED
+	checkpoint_read(populationStart, sizeof(populationStart));
+	for(i = 0; i <= NUM_NODES; i++)
+	{
+		partitionStart[i] = populationStart[i];
+	}
+#endif
+#if POPULATION_LAYOUT == LAYOUT_SOA
+	for(j = 0; j < DIMENSION; j++)
+	{
+		checkpoint_read(population[j], GENE_BYTES(nodePopulationSize));
+	}
+#else
+	checkpoint_read(population, nodePopulationSize * sizeof(population[0]));
+#endif
+	
+	random_set_state(&state);
+	
+	return 1;
+}
+
+#endif
+
+/** 
+ * This function seeds the random generator of this node. With RANDOM_STREAMS, every node jumps
+ * NODE_ID times from the same seed, so the nodes draw from disjoint streams of the cluster seed.
+ *
+ * @param seed The seed of the cluster.
+ */
+void seedFM(uint32_t seed)
+{
+#if RANDOM_STREAMS
+	uint8_t n;
+	
+	xoshiro_srand(seed);
+	for(n = NODE_ID; n > 0; n--)
+	{
+		xoshiro_jump();
+	}
+#else
+	/* The LFSRs keep the seeds of main.c. */
+	(void) seed;
+#endif
+}
+
+/** 
+ * This function measures how long this node takes to evaluate an individual. It is used
+ * to size the partitions when CALIBRATE_PARTITIONS is enabled.
+ *
+ * @return The time spent by CALIBRATION_EVALUATIONS evaluations (in seconds).
+ */
+float calibrationFM(void)
+{
+	chromosome_t probe[DIMENSION];
+	normalization_t normalizedChromosome[DIMENSION];
+	dimensionsize_t j;
+	uint8_t e;
+	float elapsed;
+	
+	/* Any fixed individual works, since all nodes evaluate the same one. */
+	for(j = 0; j < DIMENSION; j++)
+	{
+		probe[j] = (chromosome_t) MASK;
+	}
+	normalizationFM(probe, normalizedChromosome);
+	
+	/* The node already runs at the clock used by fitnessFM. */
+	counter_start();
+	for(e = 0; e < CALIBRATION_EVALUATIONS; e++)
+	{
+		evaluationFM(normalizedChromosome);
+	}
+	elapsed = counter_stop();
+	
+	/* Too fast to be measured, count it as a single timer tick. */
+	if(elapsed <= 0)
+	{
+		elapsed = COUNTER_INTERVAL;
+	}
+	
+	return elapsed;
+}
+
+#if NODE_ID == 0
+
+/** 
+ * This function selects a slave.
+ *
+ * @param nodeId The id of the node.
+ */
+void selectSlaveFM(slave_t nodeId)
+{
+#if LINK_CALIBRATION
+	SPI_master_set_clock(linkClock[nodeId]);
+#endif
+	PORTB &= ~(1 << SLAVE_SELECT(nodeId));
+}
+
+/** 
+ * This function deselects a slave.
+ *
+ * @param nodeId The id of the node.
+ */
+void deselectSlaveFM(slave_t nodeId)
+{
+	PORTB |= (1 << SLAVE_SELECT(nodeId));
+}
+
+/** 
+ * This function draws a random index between 0 and n - 1. Indexes are drawn from the smallest
+ * power of two not below n and rejected until they fit, so every index is equally likely.
+ *
+ * @param n The number of indexes (between 1 and POPULATION_SIZE).
+ * @return The random index.
+ */
+popsize_t randomIndexFM(popsize_t n)
+{
+	popsize_t mask;
+	popsize_t index;
+	
+	for(mask = 0; mask < n - 1; mask = (mask << 1) | 1);
+	
+	do
+	{
+#if POPULATION_SIZE < 256
+		index = random8() & mask;
+#else
+		index = random16() & mask;
+#endif
+	}
+	while(index >= n);
+	
+	return index;
+}
+
+/** 
+ * This function checks if all slaves answered their last handshake.
+ *
+ * @return 1 if all slaves are alive or 0 otherwise.
+ */
+uint8_t slavesAliveFM(void)
+{
+	slave_t i;
+	
+	for(i = 1; i < NUM_NODES; i++)
+	{
+		if(nodeHealth[i] != NODE_ALIVE)
+		{
+			return 0;
+		}
+	}
+	
+	return 1;
+}
+
+/** 
+ * This function sends a command to a slave until it answers with the expected ACK or the timeout
+ * expires. A node that misses NODE_MAX_MISSES handshakes in a row is declared dead and its
+ * individuals are moved to the other nodes in the next generation.
+ *
+ * @param nodeId The id of the node.
+ * @param command The command.
+ * @param ack The ACK expected for the command.
+ * @param parameter The first byte of the payload, sent while the ACK is received (DUMMY if there
+ * is none). It must be below 0xC0, since a busy slave takes the last byte it received as a command.
+ * @param timeout The time the slave has to answer (in ms).
+ * @return 1 if the slave answered (it is left selected for the payload) or 0 otherwise.
+ */
+uint8_t handshakeFM(slave_t nodeId, command_t command, spi_data_t ack, spi_data_t parameter, uint16_t timeout)
+{
+	spi_data_t data;
+	
+	if(nodeHealth[nodeId] == NODE_DEAD)
+	{
+		return 0;
+	}
+	
+	timeout_start(timeout);
+	
+	do
+	{
+		selectSlaveFM(nodeId);
+		
+#if POWER_SCALING && LINK_CALIBRATION
+		/* The slave waits for commands at CPU_DIV_SLOW, so the command goes at the slowest clock. */
+		SPI_master_set_clock(SPI_CLOCK_SLOWEST);
+#endif
+		
+		/* Send command and receive a response. */
+		SPDR = command;
+		while(!(SPSR & (1 << SPIF)));
+		data = SPDR;
+		
+#if POWER_SCALING && LINK_CALIBRATION
+		SPI_master_set_clock(linkClock[nodeId]);
+#endif
+		
+		/* The parameter goes along with the ACK. */
+		power_delay_ms(1);
+		SPDR = parameter;
+		while(!(SPSR & (1 << SPIF)));
+		data = SPDR;
+		
+		deselectSlaveFM(nodeId);
+		
+		/* Check if it received a ACK. */
+		if(data == ack)
+		{
+			timeout_stop();
+			nodeHealth[nodeId] = NODE_ALIVE;
+			nodeMisses[nodeId] = 0;
+			
+			/* Select it again for the payload. */
+			power_delay_ms(1);
+			selectSlaveFM(nodeId);
+			return 1;
+		}
+		
+#if POWER_SCALING
+		/* Nothing to do until the slave answers. */
+		power_set_div(CPU_DIV_SLOW);
+#endif
+		power_delay_ms(1);
+#if POWER_SCALING
+		power_set_div(CPU_DIV_FAST);
+#endif
+	}
+	while(!timeout_expired());
+	
+	timeout_stop();
+	
+	nodeHealth[nodeId] = NODE_SUSPECT;
+	if(++nodeMisses[nodeId] >= NODE_MAX_MISSES)
+	{
+		nodeHealth[nodeId] = NODE_DEAD;
+		healthChanged = 1;
+	}
+	
+	return 0;
+}
+
+#if LINK_CALIBRATION
+
+/** 
+ * This function finds the SPI clock used with a slave. Starting from the slowest clock, it tests
+ * each faster one until the first test fails, then it keeps LINK_MARGIN steps below the last clock that passed.
+ *
+ * @param nodeId The id of the node.
+ */
+void calibrateLinkFM(slave_t nodeId)
+{
+	uint8_t setting;
+	
+	/* The handshakes already work at the slowest clock. */
+	setting = SPI_CLOCK_SLOWEST;
+	while(setting > SPI_CLOCK_FASTEST && testLinkFM(nodeId, setting - 1))
+	{
+		setting--;
+	}
+	
+	/* A failed test leaves the slave behind in its answer, the retries of this handshake clock it out. The
+	slave leaves the test at the slowest clock (a dead node keeps it). */
+	if(handshakeFM(nodeId, CMD_LINK_DONE, ACK_LINK_DONE, DUMMY, HANDSHAKE_TIMEOUT_MS))
+	{
+		deselectSlaveFM(nodeId);
+		power_delay_ms(1);
+		
+		linkClock[nodeId] = (setting + LINK_MARGIN < SPI_CLOCK_SLOWEST) ? setting + LINK_MARGIN : SPI_CLOCK_SLOWEST;
+	}
+}
+
+/** 
+ * This function sends LINK_TEST_INDIVIDUALS known individuals (each one followed by a fitness value) to a
+ * slave at a given SPI clock and reads them back. Both sides use the same loops as the real transfers, so
+ * the test includes the time each node needs between bytes.
+ *
+ * @param nodeId The id of the node.
+ * @param setting The SPI clock setting (SPI_CLOCK_FASTEST to SPI_CLOCK_SLOWEST).
+ * @return 1 if all individuals came back or 0 otherwise.
+ */
+uint8_t testLinkFM(slave_t nodeId, uint8_t setting)
+{
+	chromosome_t x[DIMENSION];
+	chromosome_t y[DIMENSION];
+	float_bytes sent;
+	float_bytes received;
+	dimensionsize_t j, b;
+	uint8_t k, failed;
+	
+	/* The handshake runs at the clock of the link (see handshakeFM), only the individuals at the tested one. */
+	if(!handshakeFM(nodeId, CMD_LINK_TEST, ACK_LINK_TEST, DUMMY, HANDSHAKE_TIMEOUT_MS))
+	{
+		return 0;
+	}
+	SPI_master_set_clock(setting);
+	
+	failed = 0;
+	for(k = 0; k < LINK_TEST_INDIVIDUALS; k++)
+	{
+		/* Alternating bits (0x55, 0xAA) mixed with the individual, so every line toggles often. */
+		for(j = 0; j < DIMENSION; j++)
+		{
+			x[j] = (chromosome_t) ((((j + k) & 1) ? 0x55555555UL : 0xAAAAAAAAUL) ^ (0x01010101UL * k)) & GENE_MAX;
+		}
+		for(b = 0; b < sizeof(float); b++)
+		{
+			sent.bytes[b] = (((b + k) & 1) ? 0x55 : 0xAA) ^ k;
+		}
+		
+		spiWriteIndividualFM(x, 0, 0);
+		for(b = 0; b < sizeof(float); b++)
+		{
+			SPDR = sent.bytes[b];
+			while(!(SPSR & (1 << SPIF)));
+			(void) SPDR;
+		}
+		
+		spiReadIndividualFM(y, 0, 0);
+		for(b = 0; b < sizeof(float); b++)
+		{
+			SPDR = DUMMY;
+			while(!(SPSR & (1 << SPIF)));
+			received.bytes[b] = SPDR;
+		}
+		
+		for(j = 0; j < DIMENSION; j++)
+		{
+			if(y[j] != x[j])
+			{
+				failed = 1;
+			}
+		}
+		for(b = 0; b < sizeof(float); b++)
+		{
+			if(received.bytes[b] != sent.bytes[b])
+			{
+				failed = 1;
+			}
+		}
+	}
+	
+	/* Disable the selected slave */
+	deselectSlaveFM(nodeId);
+	SPI_master_set_clock(linkClock[nodeId]);
+	power_delay_ms(1);
+	
+	return !failed;
+}
+
+#endif
+
+/** 
+ * This function is run by the master tell all slaves to continue their operations.
+ *
+ * @param nodeId The node id.
+ */
+void continueOperationsFM(slave_t nodeId)
+{	
+	if(handshakeFM(nodeId, CMD_CONTINUE_OPERATIONS, ACK_CONTINUE_OPERATIONS, DUMMY, HANDSHAKE_TIMEOUT_MS))
+	{
+		deselectSlaveFM(nodeId);
+	}
+}
+
+/** 
+ * This function is run by the master to tell all slaves to continue their operations. With
+ * BROADCAST_SELECT, they are released by a single broadcast once the ready line shows that all of
+ * them wait for a command, otherwise each one gets its own handshake.
+ */
+void continueAllOperationsFM(void)
+{
+	slave_t i;
+	
+#if BROADCAST_SELECT
+	if(slavesAliveFM() && slavesReadyFM(HANDSHAKE_TIMEOUT_MS))
+	{
+		broadcastFM(CMD_BROADCAST_CONTINUE);
+		return;
+	}
+#endif
+	
+	for(i = 1; i < NUM_NODES; i++)
+	{
+		continueOperationsFM(i);
+	}
+}
+
+#if BROADCAST_SELECT
+
+/** 
+ * This function waits until all slaves wait for a command. Each slave holds the ready line low
+ * while it is busy, so the line only goes high when the last one is ready. The line is only used
+ * while all slaves are alive, since a slave that hangs may hold it low.
+ *
+ * @param timeout The time the slaves have to get ready (in ms).
+ * @return 1 if all slaves are ready or 0 otherwise.
+ */
+uint8_t slavesReadyFM(uint16_t timeout)
+{
+	uint8_t ready;
+	
+	timeout_start(timeout);
+	
+#if POWER_SCALING
+	/* Nothing to do until the slaves are ready. */
+	power_set_div(CPU_DIV_SLOW);
+#endif
+	
+	do
+	{
+		ready = (PIND & (1 << READY)) != 0;
+	}
+	while(!ready && !timeout_expired());
+	
+#if POWER_SCALING
+	power_set_div(CPU_DIV_FAST);
+#endif
+	
+	timeout_stop();
+	
+	return ready;
+}
+
+/** 
+ * This function sends a command to all healthy slaves at once, with all their slave-select lines
+ * asserted. The slaves keep MISO tri-stated while they wait for a command, so it has no ACK and
+ * it must only be sent when all of them are ready (see slavesReadyFM).
+ *
+ * @param command The command.
+ */
+void broadcastFM(command_t command)
+{
+	slave_t i;
+	uint8_t selected;
+#if !POWER_SCALING && LINK_CALIBRATION
+	uint8_t clock;
+#endif
+	
+#if POWER_SCALING
+	/* The slaves wait for commands at CPU_DIV_SLOW, so use the slowest clock. */
+	SPI_master_set_clock(SPI_CLOCK_SLOWEST);
+#elif LINK_CALIBRATION
+	/* Every slave must follow the clock, so use the slowest link. */
+	clock = SPI_CLOCK_FASTEST;
+	for(i = 1; i < NUM_NODES; i++)
+	{
+		if(nodeHealth[i] != NODE_DEAD && linkClock[i] > clock)
+		{
+			clock = linkClock[i];
+		}
+	}
+	SPI_master_set_clock(clock);
+#endif
+	
+	selected = 0;
+	for(i = 1; i < NUM_NODES; i++)
+	{
+		if(nodeHealth[i] != NODE_DEAD)
+		{
+			selected |= (1 << SLAVE_SELECT(i));
+		}
+	}
+	
+	PORTB &= ~selected;
+	
+	SPDR = command;
+	while(!(SPSR & (1 << SPIF)));
+	
+	PORTB |= selected;
+}
+
+#endif
+
+/* This function is run only by the master. It synchronizes all slaves and sends them their partition sizes. */
+generationsize_t synchronizationFM(population_t population[][POPULATION_COLUMNS])
+{
+	slave_t i;
+#if CHECKPOINT_INTERVAL
+	generationsize_t resumed;
+#endif
+#if RANDOM_STREAMS
+	uint32_t seed;
+	uint8_t b;
+	
+	/* The seed of each run is drawn from the stream of the previous one. */
+	seed = random32();
+	seedFM(seed);
+#endif
+#if !CHECKPOINT_INTERVAL
+	/* Only a resumed run loads the population here. */
+	(void) population;
+#endif
+	
+	/* Every node gets a new chance at the beginning of a run. */
+	nodeHealth[0] = NODE_ALIVE;
+	for(i = 1; i < NUM_NODES; i++)
+	{
+		nodeHealth[i] = NODE_ALIVE;
+		nodeMisses[i] = 0;
+#if LINK_CALIBRATION
+		/* A node that rebooted may not keep up with the previous clock. */
+		linkClock[i] = SPI_CLOCK_SLOWEST;
+#endif
+		
+		/* A node that does not show up (even after rebooting) is left out of the run. */
+		if(handshakeFM(i, CMD_SYNC, ACK_SYNC, DUMMY, SYNC_TIMEOUT_MS))
+		{
+#if RANDOM_STREAMS
+			/* Send the seed, least significant byte first. */
+			for(b = 0; b < sizeof(seed); b++)
+			{
+				SPDR = (spi_data_t) (seed >> (8 * b));
+				while(!(SPSR & (1 << SPIF)));
+				(void) SPDR;
+			}
+#endif
+			deselectSlaveFM(i);
+			power_delay_ms(1);
+		}
+		else
+		{
+			nodeHealth[i] = NODE_DEAD;
+		}
+	}
+	
+#if LINK_CALIBRATION
+	for(i = 1; i < NUM_NODES; i++)
+	{
+		calibrateLinkFM(i);
+	}
+#endif
+	
+#if GA_MODE != GA_MODE_MASTER_WORKER
+	/* The speeds are needed by a resumed run too, to move the individuals of a node that dies later. */
+#if CALIBRATE_PARTITIONS
+	/* The master also selects and communicates, so it only gets part of its measured speed. */
+	nodeSpeed[0] = (MASTER_LOAD_PERCENT / 100.0) / calibrationFM();
+	
+	/* The slaves measured themselves in the meantime. */
+	for(i = 1; i < NUM_NODES; i++)
+	{
+		nodeSpeed[i] = 1.0 / collectCalibrationFM(i);
+	}
+#else
+	for(i = 0; i < NUM_NODES; i++)
+	{
+		nodeSpeed[i] = nodeWeights[i];
+	}
+#endif
+#endif
+	
+#if CHECKPOINT_INTERVAL
+	/* After a reset, continue from the newest checkpoint saved by all nodes. */
+	resumed = agreeCheckpointFM(population);
+	if(resumed > 0)
+	{
+		return resumed;
+	}
+#endif
+	
+#if GA_MODE == GA_MODE_MASTER_WORKER
+
+	/* The master stores the whole population. */
+	nodePopulationSize = POPULATION_SIZE;
+
+#else
+
+	partitionFM();
+	
+	/* Nobody stores a population yet, so both layouts are the same. */
+	for(i = 0; i <= NUM_NODES; i++)
+	{
+		populationStart[i] = partitionStart[i];
+	}
+	
+	nodePopulationSize = partitionStart[1];
+	for(i = 1; i < NUM_NODES; i++)
+	{
+		sendPartitionFM(i, partitionStart[i + 1] - partitionStart[i]);
+	}
+	
+#endif
+
+	return 0;
+}
+
+#if CHECKPOINT_INTERVAL
+
+/** 
+ * This function is run only by the master. In the first run after a reset, it looks for the newest
+ * checkpoint saved by all nodes and tells them to resume from it. Otherwise, it starts a new epoch
+ * (which is only stored in the EEPROM along with the checkpoints of the run).
+ *
+ * @param population A vector that will store the individuals.
+ * @return The generation to resume from (0 to start a new run).
+ */
+generationsize_t agreeCheckpointFM(population_t population[][POPULATION_COLUMNS])
+{
+	uint16_t epochs[CHECKPOINT_RECENT];
+	uint16_t generations[CHECKPOINT_RECENT];
+	uint16_t next;
+	uint16_t chosen;
+	uint8_t s;
+#if GA_MODE == GA_MODE_PARTITIONED
+	slave_t i;
+	uint16_t slaveEpochs[NUM_NODES][CHECKPOINT_RECENT];
+	uint16_t slaveGenerations[NUM_NODES][CHECKPOINT_RECENT];
+	uint8_t t;
+	uint8_t found;
+#endif
+	
+	chosen = CHECKPOINT_NONE;
+	
+	/* Later runs just take the next epoch, it is only stored along with their checkpoints. */
+	if(started)
+	{
+		epoch++;
+	}
+	else
+	{
+		started = 1;
+		
+		/* The epoch is not stored, a new run takes the one after the newest checkpoint of any node. */
+		checkpoint_recent(epochs, generations);
+		next = 0;
+		for(s = 0; s < CHECKPOINT_RECENT; s++)
+		{
+			if(generations[s] != CHECKPOINT_NONE && epochs[s] >= next)
+			{
+				next = epochs[s] + 1;
+			}
+		}
+		
+#if GA_MODE == GA_MODE_PARTITIONED
+		/* A dead node cannot resume, so the whole cluster starts again. */
+		for(i = 1; i < NUM_NODES; i++)
+		{
+			if(!collectCheckpointsFM(i, slaveEpochs[i], slaveGenerations[i]))
+			{
+				for(s = 0; s < CHECKPOINT_RECENT; s++)
+				{
+					slaveGenerations[i][s] = CHECKPOINT_NONE;
+				}
+			}
+			
+			for(s = 0; s < CHECKPOINT_RECENT; s++)
+			{
+				if(slaveGenerations[i][s] != CHECKPOINT_NONE && slaveEpochs[i][s] >= next)
+				{
+					next = slaveEpochs[i][s] + 1;
+				}
+			}
+		}
+#endif
+		
+		/* The newest checkpoint of the master belongs to the interrupted run, unless it marks the end of
+		a run that finished (a run that ended normally is never resumed). */
+		for(s = 0; s < CHECKPOINT_RECENT && generations[0] < NUM_GENERATIONS && chosen == CHECKPOINT_NONE; s++)
+		{
+			if(generations[s] == CHECKPOINT_NONE || epochs[s] != epochs[0])
+			{
+				continue;
+			}
+			
+#if GA_MODE == GA_MODE_PARTITIONED
+			/* Every slave must have the same generation of the same epoch. */
+			for(i = 1; i < NUM_NODES; i++)
+			{
+				found = 0;
+				for(t = 0; t < CHECKPOINT_RECENT; t++)
+				{
+					if(slaveEpochs[i][t] == epochs[s] && slaveGenerations[i][t] == generations[s])
+					{
+						found = 1;
+					}
+				}
+				
+				if(!found)
+				{
+					break;
+				}
+			}
+			
+			if(i < NUM_NODES)
+			{
+				continue;
+			}
+#endif
+			
+			epoch = epochs[s];
+			if(resumeFM(population, generations[s]))
+			{
+				chosen = generations[s];
+			}
+		}
+		
+		if(chosen == CHECKPOINT_NONE)
+		{
+			epoch = next;
+		}
+	}
+	
+#if GA_MODE == GA_MODE_PARTITIONED
+	for(i = 1; i < NUM_NODES; i++)
+	{
+		sendResumeFM(i, chosen);
+	}
+#endif
+	
+	return chosen == CHECKPOINT_NONE ? 0 : chosen;
+}
+
+#if GA_MODE == GA_MODE_PARTITIONED
+
+/** 
+ * This function collects the newest checkpoints (epoch and generation) of a slave.
+ *
+ * @param nodeId The id of the node.
+ * @param epochs A vector that will store the epoch of each checkpoint.
+ * @param generations A vector that will store the generation of each checkpoint (CHECKPOINT_NONE if there are fewer).
+ * @return 1 if the checkpoints were collected or 0 if the slave did not answer.
+ */
+uint8_t collectCheckpointsFM(slave_t nodeId, uint16_t epochs[], uint16_t generations[])
+{
+	uint8_t s;
+	dimensionsize_t b;
+	
+	if(!handshakeFM(nodeId, CMD_COLLECT_CHECKPOINT, ACK_COLLECT_CHECKPOINT, DUMMY, HANDSHAKE_TIMEOUT_MS))
+	{
+		return 0;
+	}
+	
+	/* Receive the epoch and the generation of each checkpoint, least significant byte first. */
+	for(s = 0; s < CHECKPOINT_RECENT; s++)
+	{
+		epochs[s] = 0;
+		generations[s] = 0;
+		for(b = 0; b < 2; b++)
+		{
+			SPDR = DUMMY;
+			while(!(SPSR & (1 << SPIF)));
+			epochs[s] |= (uint16_t) SPDR << (8 * b);
+		}
+		for(b = 0; b < 2; b++)
+		{
+			SPDR = DUMMY;
+			while(!(SPSR & (1 << SPIF)));
+			generations[s] |= (uint16_t) SPDR << (8 * b);
+		}
+	}
+	
+	/* Disable the selected slave */
+	deselectSlaveFM(nodeId);
+	
+	return 1;
+}
+
+/** 
+ * This function tells a slave the epoch of the run and the checkpoint to resume from.
+ *
+ * @param nodeId The id of the node.
+ * @param generation The generation of the checkpoint (CHECKPOINT_NONE to start a new run).
+ */
+void sendResumeFM(slave_t nodeId, uint16_t generation)
+{
+	dimensionsize_t b;
+	
+	if(!handshakeFM(nodeId, CMD_RESUME, ACK_RESUME, DUMMY, HANDSHAKE_TIMEOUT_MS))
+	{
+		return;
+	}
+	
+	/* Send the epoch and the generation, least significant byte first. */
+	for(b = 0; b < 2; b++)
+	{
+		SPDR = (spi_data_t) (epoch >> (8 * b));
+		while(!(SPSR & (1 << SPIF)));
+		(void) SPDR;
+	}
+	for(b = 0; b < 2; b++)
+	{
+		SPDR = (spi_data_t) (generation >> (8 * b));
+		while(!(SPSR & (1 << SPIF)));
+		(void) SPDR;
+	}
+	
+	/* Disable the selected slave */
+	deselectSlaveFM(nodeId);
+}
+
+#endif
+
+#endif
+
+#if GA_MODE == GA_MODE_PARTITIONED
+
+void collectBestIndividualsFM(chromosome_t bestIndividuals[][DIMENSION], fitness_t bestFitness[], population_t population[][POPULATION_COLUMNS])
+{
+	chromosome_t received[ELITES][DIMENSION];
+	fitness_t receivedFitness[ELITES];
+	float_bytes value;
+	slave_t i;
+	dimensionsize_t j, b;
+	uint8_t e, m, n, count;
+	
+	/* Start from the elites of the master (fitnessFM already sorted them). */
+	for(e = 0; e < ELITES; e++)
+	{
+		for(j = 0; j < DIMENSION; j++)
+		{
+			bestIndividuals[e][j] = GET_GENE(population, eliteIndex[e], j);
+		}
+		bestFitness[e] = eliteFitness[e];
+	}
+	
+	/* Collect the elites of the other slaves. */
+	for(i = 1; i < NUM_NODES; i++)
+	{
+		if(!handshakeFM(i, CMD_COLLECT_BEST_IND, ACK_COLLECT_BEST_IND, DUMMY, HANDSHAKE_TIMEOUT_MS))
+		{
+			/* Its best individuals are unknown, so leave them out of the comparison. */
+			nodeHealth[i] = NODE_DEAD;
+			continue;
+		}
+		
+#if BEST_FITNESS_FIRST
+		/* Receive the fitness values of its elites first. */
+		for(n = 0; n < ELITES; n++)
+		{
+			for(b = 0; b < sizeof(float); b++)
+			{
+				SPDR = DUMMY;
+				while(!(SPSR & (1 << SPIF)));
+				value.bytes[b] = SPDR;
+			}
+			receivedFitness[n] = value.value;
+		}
+		
+		/* Both lists are sorted, so the elites of the slave that enter the ELITES best are its first ones. */
+		count = 0;
+		for(e = 0; e < ELITES; e++)
+		{
+			if(receivedFitness[count] < bestFitness[e - count])
+			{
+				count++;
+			}
+		}
+		
+		/* Ask only for these individuals. */
+		power_delay_ms(1);
+		SPDR = count;
+		while(!(SPSR & (1 << SPIF)));
+		
+		for(n = 0; n < count; n++)
+		{
+			spiReadIndividualFM(received[n], 0, 0);
+		}
+#else
+		/* Receive each elite after its fitness value. */
+		count = ELITES;
+		for(n = 0; n < ELITES; n++)
+		{
+			for(b = 0; b < sizeof(float); b++)
+			{
+				SPDR = DUMMY;
+				while(!(SPSR & (1 << SPIF)));
+				value.bytes[b] = SPDR;
+			}
+			receivedFitness[n] = value.value;
+			
+			spiReadIndividualFM(received[n], 0, 0);
+		}
+#endif
+		deselectSlaveFM(i);
+		
+		/* Merge them with the best ones so far, the slave already evaluated them. */
+		for(n = 0; n < count; n++)
+		{
+			/* The elites of a slave are sorted, so the next ones cannot enter the list either. */
+			e = elitePositionFM(bestFitness, ELITES, receivedFitness[n]);
+			if(e == ELITES)
+			{
+				break;
+			}
+			
+			for(m = ELITES - 1; m > e; m--)
+			{
+				for(j = 0; j < DIMENSION; j++)
+				{
+					bestIndividuals[m][j] = bestIndividuals[m - 1][j];
+				}
+				bestFitness[m] = bestFitness[m - 1];
+			}
+			for(j = 0; j < DIMENSION; j++)
+			{
+				bestIndividuals[e][j] = received[n][j];
+			}
+			bestFitness[e] = receivedFitness[n];
+		}
+	}
+}
+
+#endif
+
+#if GA_MODE == GA_MODE_MASTER_WORKER
+
+/* This function is run only by the master. It holds the whole population, so the selection and crossover are local. */
+void selectionCrossoverProcessing(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], population_t newPopulation[][POPULATION_COLUMNS])
+{
+	popsize_t iWinnerX, iWinnerY;
+	popsize_t i, a, b;
+	dimensionsize_t j;
+	
+	for(i = 0; i < POPULATION_SIZE; i += 2) /* Process the whole population. */
+	{
+		/* Randomly pick 4 individuals and keep the 2 winners. */
+#if POPULATION_SIZE < 256
+		a = random8() & (POPULATION_SIZE - 1);
+		b = random8() & (POPULATION_SIZE - 1);
+		iWinnerX = (evaluation[a] < evaluation[b]) ? a : b;
+		a = random8() & (POPULATION_SIZE - 1);
+		b = random8() & (POPULATION_SIZE - 1);
+		iWinnerY = (evaluation[a] < evaluation[b]) ? a : b;
+#else
+		a = random16() & (POPULATION_SIZE - 1);
+		b = random16() & (POPULATION_SIZE - 1);
+		iWinnerX = (evaluation[a] < evaluation[b]) ? a : b;
+		a = random16() & (POPULATION_SIZE - 1);
+		b = random16() & (POPULATION_SIZE - 1);
+		iWinnerY = (evaluation[a] < evaluation[b]) ? a : b;
+#endif
+
+		/* Do the crossover of the individuals. */
+		for(j = 0; j < DIMENSION; j++)
+		{
+			/* Two chromosomes exchanges their genes between each other */
+			SET_GENE(newPopulation, i, j, (GET_GENE(population, iWinnerX, j) & MASK) | (GET_GENE(population, iWinnerY, j) & ~MASK));
+			SET_GENE(newPopulation, i+1, j, (GET_GENE(population, iWinnerX, j) & ~MASK) | (GET_GENE(population, iWinnerY, j) & MASK));
+		}
+	}
+}
+
+/** 
+ * This function streams a batch of individuals from master to a worker, which starts evaluating them.
+ *
+ * @param population A vector containing the individuals.
+ * @param first The index of the first individual of the batch.
+ * @param count The number of individuals (up to EVALUATION_BATCH_SIZE).
+ * @param nodeId The id of the worker.
+ * @return 1 if the batch was sent or 0 if the worker did not answer.
+ */
+uint8_t sendBatchFM(population_t population[][POPULATION_COLUMNS], popsize_t first, popsize_t count, slave_t nodeId)
+{
+	popsize_t i;
+#if INDIVIDUAL_COPY
+	chromosome_t x[DIMENSION];
+#endif
+	
+	/* The size of the batch goes along with the ACK. */
+	if(!handshakeFM(nodeId, CMD_EVALUATE_BATCH, ACK_EVALUATE_BATCH, count, HANDSHAKE_TIMEOUT_MS))
+	{
+		return 0;
+	}
+	
+	/* Send the individuals. */
+	for(i = first; i < first + count; i++)
+	{
+		spiWriteIndividualFM(INDIVIDUAL(population, i, x), 0, 0);
+	}
+	
+	/* Disable the selected slave */
+	deselectSlaveFM(nodeId);
+	
+	return 1;
+}
+
+/** 
+ * This function collects the fitness values of the last batch sent to a worker. It waits
+ * until the worker finishes the evaluation.
+ *
+ * @param evaluation A vector that will store the fitness values.
+ * @param count The number of individuals of the batch.
+ * @param nodeId The id of the worker.
+ * @return 1 if the values were collected or 0 if the worker did not answer.
+ */
+uint8_t collectBatchFM(fitness_t evaluation[], popsize_t count, slave_t nodeId)
+{
+	float_bytes received;
+	popsize_t i;
+	dimensionsize_t b;
+	
+	/* The worker does not answer while it is evaluating. */
+	if(!handshakeFM(nodeId, CMD_COLLECT_BATCH, ACK_COLLECT_BATCH, DUMMY, HANDSHAKE_TIMEOUT_MS))
+	{
+		return 0;
+	}
+	
+	/* Now receive 4 bytes per individual. */
+	for(i = 0; i < count; i++)
+	{
+		for(b = 0; b < sizeof(float); b++)
+		{
+			SPDR = DUMMY;
+			while(!(SPSR & (1 << SPIF)));
+			received.bytes[b] = SPDR;
+		}
+		evaluation[i] = received.value;
+	}
+	
+	/* Disable the selected slave */
+	deselectSlaveFM(nodeId);
+	
+	return 1;
+}
+
+#else
+
+#if CELLULAR
+
+/* This function is run only by the master. In the cellular GA each node breeds its own rows of the grid,
+so the master only relays the first and the last row of each node to the nodes next to it in the grid (the
+previous and the next healthy nodes, the grid wraps around). */
+void selectionCrossoverProcessing(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], population_t newPopulation[][POPULATION_COLUMNS])
+{
+	/* The first row of each node followed by its last row. */
+	chromosome_t border[NUM_NODES][2 * CELL_WIDTH][DIMENSION];
+	fitness_t borderFitness[NUM_NODES][2 * CELL_WIDTH];
+	uint8_t answered[NUM_NODES];
+	slave_t i, previous, next;
+	uint8_t c;
+	dimensionsize_t j;
+	
+	/* Move the rows of the nodes that died to the healthy ones, the new rows start as the worst ones. */
+	if(healthChanged)
+	{
+		healthChanged = 0;
+		partitionFM();
+		
+		for(i = 1; i < NUM_NODES; i++)
+		{
+			sendPartitionFM(i, partitionStart[i + 1] - partitionStart[i]);
+		}
+		for(i = 0; i <= NUM_NODES; i++)
+		{
+			populationStart[i] = partitionStart[i];
+		}
+		resizePartitionFM(evaluation, population, partitionStart[1]);
+	}
+	
+	/* Grab the rows of the master and of the slaves. */
+	for(c = 0; c < CELL_WIDTH; c++)
+	{
+		for(j = 0; j < DIMENSION; j++)
+		{
+			border[0][c][j] = GET_GENE(population, c, j);
+			border[0][CELL_WIDTH + c][j] = GET_GENE(population, nodePopulationSize - CELL_WIDTH + c, j);
+		}
+		borderFitness[0][c] = evaluation[c];
+		borderFitness[0][CELL_WIDTH + c] = evaluation[nodePopulationSize - CELL_WIDTH + c];
+	}
+	answered[0] = 1;
+	
+	for(i = 1; i < NUM_NODES; i++)
+	{
+		answered[i] = (nodeHealth[i] != NODE_DEAD && collectBorderFM(i, border[i], borderFitness[i]));
+	}
+	
+	/* The nodes that did not answer are left out of the grid in this generation. */
+	for(i = 0; i < NUM_NODES; i++)
+	{
+		if(!answered[i])
+		{
+			continue;
+		}
+		
+		for(previous = (i + NUM_NODES - 1) % NUM_NODES; !answered[previous]; previous = (previous + NUM_NODES - 1) % NUM_NODES);
+		for(next = (i + 1) % NUM_NODES; !answered[next]; next = (next + 1) % NUM_NODES);
+		
+		if(i > 0)
+		{
+			sendHaloFM(i, &border[previous][CELL_WIDTH], &borderFitness[previous][CELL_WIDTH], border[next], borderFitness[next]);
+			continue;
+		}
+		
+		for(c = 0; c < CELL_WIDTH; c++)
+		{
+			for(j = 0; j < DIMENSION; j++)
+			{
+				halo[c][j] = border[previous][CELL_WIDTH + c][j];
+				halo[CELL_WIDTH + c][j] = border[next][c][j];
+			}
+			haloFitness[c] = borderFitness[previous][CELL_WIDTH + c];
+			haloFitness[CELL_WIDTH + c] = borderFitness[next][c];
+		}
+	}
+	
+	/* Continue operation in all slaves. */
+	continueAllOperationsFM();
+}
+
+#else
+
+/* This function is run only by the master. It controls the selection and crossover of all nodes. The
+tournaments are scheduled in batches of SELECTION_BATCH pairs, so each slave gets one request per batch
+for the fitness values, one for the winners and one for the new individuals. Tournaments between two
+individuals of the same slave are resolved by the slave itself, so their fitness values are not transferred. */
+void selectionCrossoverProcessing(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], population_t newPopulation[][POPULATION_COLUMNS])
+{
+	/* Node and index (inside its node) of each contender. */
+	slave_t node[4 * SELECTION_BATCH];
+	popsize_t index[4 * SELECTION_BATCH];
+	/* The winners, which are replaced by the new individuals. */
+	chromosome_t individuals[2 * SELECTION_BATCH][DIMENSION];
+	chromosome_t x, y;
+	popsize_t i, first, pairs;
+	popsize_t populationSize;
+	uint8_t c;
+	dimensionsize_t j;
+	
+	/* Move the individuals of the nodes that died to the healthy ones. The current population
+	keeps its layout (populationStart), the new one is stored with the new layout (partitionStart). */
+	if(healthChanged)
+	{
+		healthChanged = 0;
+		partitionFM();
+		
+		for(i = 1; i < NUM_NODES; i++)
+		{
+			sendPartitionFM(i, partitionStart[i + 1] - partitionStart[i]);
+		}
+	}
+	populationSize = partitionStart[NUM_NODES];
+	
+	for(first = 0; first < populationSize; first += 2 * pairs) /* Process the whole population. */
+	{
+		pairs = (populationSize - first + 1) / 2;
+		if(pairs > SELECTION_BATCH)
+		{
+			pairs = SELECTION_BATCH;
+		}
+		
+		/* Randomly pick 4 individuals for each pair of new individuals (in the same order as one
+		pair at a time) and find the microcontrollers that store them. */
+		for(c = 0; c < 4 * pairs; c++)
+		{
+			node[c] = drawIndividualFM(&index[c]);
+		}
+		
+		/* Now, do the tournament method between contenders c and c + 1 and grab the winners. */
+		tournamentsFM(evaluation, population, node, index, individuals, 2 * pairs);
+		
+		/* Do the crossover of the individuals. */
+		for(c = 0; c < 2 * pairs; c += 2)
+		{
+			for(j = 0; j < DIMENSION; j++)
+			{
+				/* Two chromosomes exchanges their genes between each other */
+				x = individuals[c][j];
+				y = individuals[c + 1][j];
+				individuals[c][j] = (x & MASK) | (y & ~MASK);
+				individuals[c + 1][j] = (x & ~MASK) | (y & MASK);
+			}
+		}
+		
+		/* Store the new individuals in the nodes that own their positions. */
+		storeOffspringFM(individuals, first, (populationSize - first < 2 * pairs) ? populationSize - first : 2 * pairs, newPopulation);
+	}
+	
+	/* The new population uses the new layout from now on. */
+	for(i = 0; i <= NUM_NODES; i++)
+	{
+		populationStart[i] = partitionStart[i];
+	}
+	nodePopulationSize = partitionStart[1];
+	
+	/* Continue operation in all slaves. */
+	continueAllOperationsFM();
+}
+
+#endif
+
+/** 
+ * This function splits the population between the healthy nodes proportionally to their speed
+ * (nodeSpeed). Each partition stays between NODE_POPULATION_MIN and NODE_POPULATION_MAX individuals,
+ * so the population shrinks if the healthy nodes cannot store POPULATION_SIZE individuals. Every
+ * partition is a multiple of PARTITION_UNIT individuals.
+ */
+void partitionFM(void)
+{
+	uint16_t size[NUM_NODES];
+	uint16_t assigned, target;
+	float total;
+	slave_t i, chosen;
+	
+	total = 0;
+	target = 0;
+	for(i = 0; i < NUM_NODES; i++)
+	{
+		if(nodeHealth[i] != NODE_DEAD)
+		{
+			total += nodeSpeed[i];
+			target += PARTITION_MAX;
+		}
+	}
+	
+	/* The sizes are counted in units of PARTITION_UNIT individuals. */
+	if(target > POPULATION_SIZE / PARTITION_UNIT)
+	{
+		target = POPULATION_SIZE / PARTITION_UNIT;
+	}
+	
+	assigned = 0;
+	for(i = 0; i < NUM_NODES; i++)
+	{
+		if(nodeHealth[i] == NODE_DEAD)
+		{
+			size[i] = 0;
+			continue;
+		}
+		
+		size[i] = (uint16_t) (target * nodeSpeed[i] / total);
+		
+		if(size[i] < PARTITION_MIN)
+		{
+			size[i] = PARTITION_MIN;
+		}
+		else if(size[i] > PARTITION_MAX)
+		{
+			size[i] = PARTITION_MAX;
+		}
+		assigned += size[i];
+	}
+	
+	/* Give the rounding remainder to the node that is least loaded for its speed. */
+	while(assigned < target)
+	{
+		chosen = NUM_NODES;
+		for(i = 0; i < NUM_NODES; i++)
+		{
+			if(nodeHealth[i] != NODE_DEAD && size[i] < PARTITION_MAX && (chosen == NUM_NODES || nodeSpeed[i] * (size[chosen] + 1) > nodeSpeed[chosen] * (size[i] + 1)))
+			{
+				chosen = i;
+			}
+		}
+		size[chosen]++;
+		assigned++;
+	}
+	
+	/* Or take it back from the node that is most loaded for its speed. */
+	while(assigned > target)
+	{
+		chosen = NUM_NODES;
+		for(i = 0; i < NUM_NODES; i++)
+		{
+			if(nodeHealth[i] != NODE_DEAD && size[i] > PARTITION_MIN && (chosen == NUM_NODES || nodeSpeed[i] * size[chosen] < nodeSpeed[chosen] * size[i]))
+			{
+				chosen = i;
+			}
+		}
+		size[chosen]--;
+		assigned--;
+	}
+	
+	partitionStart[0] = 0;
+	for(i = 0; i < NUM_NODES; i++)
+	{
+		partitionStart[i + 1] = partitionStart[i] + size[i] * PARTITION_UNIT;
+	}
+}
+
+/** 
+ * This function finds the node that stores a given individual.
+ *
+ * @param start The layout of the population (index of the first individual of each node).
+ * @param index The global index of the individual. It is replaced by the index inside the node.
+ * @return The id of the node that stores the individual.
+ */
+slave_t nodeOfIndexFM(popsize_t start[], popsize_t *index)
+{
+	slave_t nodeId;
+	
+	nodeId = 0;
+	while(*index >= start[nodeId + 1])
+	{
+		nodeId++;
+	}
+	
+	*index -= start[nodeId];
+	return nodeId;
+}
+
+/** 
+ * This function randomly picks an individual of the current population that is stored in a healthy node.
+ *
+ * @param index It will store the index of the individual inside its node.
+ * @return The id of the node that stores the individual.
+ */
+slave_t drawIndividualFM(popsize_t *index)
+{
+	slave_t nodeId;
+	
+	do
+	{
+		*index = randomIndexFM(populationStart[NUM_NODES]);
+		nodeId = nodeOfIndexFM(populationStart, index);
+	}
+	while(nodeHealth[nodeId] == NODE_DEAD);
+	
+	return nodeId;
+}
+
+/** 
+ * This function plays a list of tournaments between individuals of any node. Tournament t is played
+ * between contenders 2t and 2t + 1, and when both are stored by the same slave, it is left to that slave.
+ *
+ * @param evaluation A vector that stores the fitness values of the master.
+ * @param population A vector containing the individuals of the master.
+ * @param node The node that stores each contender (it may be changed).
+ * @param index The index of each contender inside its node (it may be changed).
+ * @param winners A vector that will store the winner of each tournament.
+ * @param count The number of tournaments.
+ */
+void tournamentsFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], slave_t node[], popsize_t index[], chromosome_t winners[][DIMENSION], uint8_t count)
+{
+	fitness_t fitness[4 * SELECTION_BATCH];
+	uint8_t c, w;
+#if PREFETCH_CONTENDERS
+	chromosome_t x[4 * SELECTION_BATCH][DIMENSION];
+	dimensionsize_t j;
+	
+	/* Both contenders of a tournament against another node come along with their fitness values,
+	so the winner is already here when the tournament is decided (the loser is discarded). */
+	collectContendersFM(evaluation, population, node, index, x, fitness, 2 * count);
+	
+	for(c = 0; c < 2 * count; c += 2)
+	{
+		w = c;
+		if(node[c] != node[c + 1] || node[c] == 0)
+		{
+			w = (fitness[c] < fitness[c + 1]) ? c : c + 1;
+		}
+		
+		for(j = 0; j < DIMENSION; j++)
+		{
+			winners[c / 2][j] = x[w][j];
+		}
+	}
+#else
+	
+	/* Grab the evaluation values of the contenders that play against another node. */
+	collectFitnessFM(evaluation, node, index, fitness, 2 * count);
+	
+	/* Both indexes of a tournament against another node are set to the winner. */
+	for(c = 0; c < 2 * count; c += 2)
+	{
+		if(node[c] != node[c + 1] || node[c] == 0)
+		{
+			w = (fitness[c] < fitness[c + 1]) ? c : c + 1;
+			node[c] = node[w];
+			index[c] = index[w];
+			index[c + 1] = index[w];
+		}
+	}
+	
+	/* Grab the winners. */
+	collectWinnersFM(population, node, index, winners, count);
+#endif
+}
+
+#if PREFETCH_CONTENDERS
+
+/** 
+ * This function collects a list of tournament contenders, with one request per slave. A tournament
+ * between two individuals of the same slave is a single request with both indexes, and the slave
+ * sends back the winner. Each contender of a tournament against another node is a request with its
+ * index twice, and the slave sends it back followed by its fitness value.
+ *
+ * @param evaluation A vector that stores the fitness values of the master.
+ * @param population A vector containing the individuals of the master.
+ * @param node The node that stores each contender.
+ * @param index The index of each contender inside its node.
+ * @param x A vector that will store the contenders (the winner in place of the first one for the tournaments inside a slave).
+ * @param fitness A vector that will store their fitness values (FITNESS_WORST if the slave did not answer).
+ * @param count The number of contenders.
+ */
+void collectContendersFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], slave_t node[], popsize_t index[], chromosome_t x[][DIMENSION], fitness_t fitness[], uint8_t count)
+{
+	slave_t nodeId;
+	uint8_t c, n, k, previous, fetch;
+	dimensionsize_t j, b;
+	float_bytes received;
+	spi_data_t next[2];
+	
+	/* If the node is the master, grab the contender directly. If a slave does not answer, use the
+	best individual of the master instead, which loses every tournament. */
+	for(c = 0; c < count; c++)
+	{
+		for(j = 0; j < DIMENSION; j++)
+		{
+			x[c][j] = GET_GENE(population, (node[c] == 0) ? index[c] : 0, j);
+		}
+		fitness[c] = (node[c] == 0) ? evaluation[index[c]] : FITNESS_WORST;
+	}
+	
+	for(nodeId = 1; nodeId < NUM_NODES; nodeId++)
+	{
+		/* The second contender of a tournament inside the slave goes along with the first one. */
+		for(c = 0, n = 0; c < count; c++)
+		{
+			n += (node[c] == nodeId && !((c & 1) && node[c - 1] == nodeId));
+		}
+		
+		/* The number of requests goes along with the ACK. */
+		if(n == 0 || !handshakeFM(nodeId, CMD_COLLECT_CONTENDERS, ACK_COLLECT_CONTENDERS, n, HANDSHAKE_TIMEOUT_MS))
+		{
+			continue;
+		}
+		
+		/* Send both indexes of the first request, the ones of each next request go along with the
+		answer to the previous one. */
+		for(c = 0, previous = count, fetch = 0; c <= count; c++)
+		{
+			if(c < count && (node[c] != nodeId || ((c & 1) && node[c - 1] == nodeId)))
+			{
+				continue;
+			}
+			
+			if(c < count)
+			{
+				next[0] = index[c];
+				next[1] = (node[c ^ 1] == nodeId) ? index[c ^ 1] : index[c];
+			}
+			
+			if(previous == count)
+			{
+				for(k = 0; k < 2; k++)
+				{
+					SPDR = next[k];
+					while(!(SPSR & (1 << SPIF)));
+					(void) SPDR;
+				}
+			}
+			else
+			{
+				spiReadIndividualFM(x[previous], next, (c < count) ? 2 : 0);
+				
+				/* Equal indexes ask for the fitness value too. */
+				if(fetch)
+				{
+					for(b = 0; b < sizeof(float); b++)
+					{
+						SPDR = DUMMY;
+						while(!(SPSR & (1 << SPIF)));
+						received.bytes[b] = SPDR;
+					}
+					fitness[previous] = received.value;
+				}
+			}
+			
+			fetch = (c < count && next[0] == next[1]);
+			previous = c;
+		}
+		
+		/* Disable the selected slave */
+		deselectSlaveFM(nodeId);
+	}
+}
+
+#else
 
-		/* Depending on the index, grab the individual from the respective microcontroller. */
-#if NUM_NODES == 2
-		if(iChromosomeX1 < POPULATION_SIZE/2)
+/** 
+ * This function collects the fitness values of a list of tournament contenders, with one request per
+ * slave. The values of contenders whose opponent (c xor 1) is stored by the same slave are not collected.
+ *
+ * @param evaluation A vector that stores the fitness values of the master.
+ * @param node The node that stores each individual.
+ * @param index The index of each individual inside its node.
+ * @param fitness A vector that will store the fitness values (FITNESS_WORST if the slave did not answer).
+ * @param count The number of individuals.
+ */
+void collectFitnessFM(fitness_t evaluation[], slave_t node[], popsize_t index[], fitness_t fitness[], uint8_t count)
+{
+	slave_t nodeId;
+	uint8_t c, n, previous;
+	float_bytes received;
+	dimensionsize_t b;
+	spi_data_t next;
+	
+	for(c = 0; c < count; c++)
+	{
+		fitness[c] = (node[c] == 0) ? evaluation[index[c]] : FITNESS_WORST;
+	}
+	
+	for(nodeId = 1; nodeId < NUM_NODES; nodeId++)
+	{
+		for(c = 0, n = 0; c < count; c++)
 		{
-			nodeChromosomeX1 = 0;
-			/* iChromosomeX remains the same value. */
+			n += (node[c] == nodeId && node[c ^ 1] != nodeId);
 		}
-		else
+		
+		/* The number of indexes goes along with the ACK. */
+		if(n == 0 || !handshakeFM(nodeId, CMD_COLLECT_EV_BATCH, ACK_COLLECT_EV_BATCH, n, HANDSHAKE_TIMEOUT_MS))
 		{
-			nodeChromosomeX1 = 1;
-			iChromosomeX1 -= POPULATION_SIZE/2; /* Calculate the relative index. */
+			continue;
 		}
-		if(iChromosomeX2 < POPULATION_SIZE/2)
+		
+		/* Send the first index, each next one goes along with the first byte of the previous fitness value. */
+		for(c = 0, previous = count; c <= count; c++)
 		{
-			nodeChromosomeX2 = 0;
-			/* iChromosomeX remains the same value. */
+			if(c < count && (node[c] != nodeId || node[c ^ 1] == nodeId))
+			{
+				continue;
+			}
+			
+			next = (c < count) ? index[c] : DUMMY;
+			if(previous == count)
+			{
+				SPDR = next;
+				while(!(SPSR & (1 << SPIF)));
+				(void) SPDR;
+				power_delay_ms(1);
+			}
+			else
+			{
+				for(b = 0; b < sizeof(float); b++)
+				{
+					SPDR = (b == 0) ? next : DUMMY;
+					while(!(SPSR & (1 << SPIF)));
+					received.bytes[b] = SPDR;
+				}
+				fitness[previous] = received.value;
+			}
+			previous = c;
 		}
-		else
+		
+		/* Disable the selected slave */
+		deselectSlaveFM(nodeId);
+	}
+}
+
+/** 
+ * This function collects the winners of a list of tournaments, with one request per slave. Tournament t
+ * is played between individuals index[2t] and index[2t + 1] of node[2t] (both indexes are the same if
+ * the master already knows the winner), and the slave sends back only the winner.
+ *
+ * @param population A vector containing the individuals of the master.
+ * @param node The node that stores the contenders of each tournament.
+ * @param index The indexes of the contenders inside their node.
+ * @param x A vector that will store the winners (the best one of the master if the slave did not answer).
+ * @param count The number of tournaments.
+ */
+void collectWinnersFM(population_t population[][POPULATION_COLUMNS], slave_t node[], popsize_t index[], chromosome_t x[][DIMENSION], uint8_t count)
+{
+	slave_t nodeId;
+	uint8_t c, n, k, previous;
+	dimensionsize_t j;
+	spi_data_t next[2];
+	
+	/* If the node is the master, grab the individual directly. If a slave does not answer,
+	use the best individual of the master instead. */
+	for(c = 0; c < count; c++)
+	{
+		for(j = 0; j < DIMENSION; j++)
 		{
-			nodeChromosomeX2 = 1;
-			iChromosomeX2 -= POPULATION_SIZE/2; /* Calculate the relative index. */
+			x[c][j] = GET_GENE(population, (node[2 * c] == 0) ? index[2 * c] : 0, j);
 		}
-		if(iChromosomeY1 < POPULATION_SIZE/2)
+	}
+	
+	for(nodeId = 1; nodeId < NUM_NODES; nodeId++)
+	{
+		for(c = 0, n = 0; c < count; c++)
 		{
-			nodeChromosomeY1 = 0;
-			/* iChromosomeY remains the same value. */
+			n += (node[2 * c] == nodeId);
 		}
-		else
+		
+		/* The number of tournaments goes along with the ACK. */
+		if(n == 0 || !handshakeFM(nodeId, CMD_TOURNAMENT_BATCH, ACK_TOURNAMENT_BATCH, n, HANDSHAKE_TIMEOUT_MS))
+		{
+			continue;
+		}
+		
+		/* Send the indexes of both contenders of the first tournament, the ones of each next
+		tournament go along with the winner of the previous one. */
+		for(c = 0, previous = count; c <= count; c++)
+		{
+			if(c < count && node[2 * c] != nodeId)
+			{
+				continue;
+			}
+			
+			if(c < count)
+			{
+				next[0] = index[2 * c];
+				next[1] = index[2 * c + 1];
+			}
+			
+			if(previous == count)
+			{
+				for(k = 0; k < 2; k++)
+				{
+					SPDR = next[k];
+					while(!(SPSR & (1 << SPIF)));
+					(void) SPDR;
+				}
+			}
+			else
+			{
+				spiReadIndividualFM(x[previous], next, (c < count) ? 2 : 0);
+			}
+			previous = c;
+		}
+		
+		/* Disable the selected slave */
+		deselectSlaveFM(nodeId);
+	}
+}
+
+#endif
+
+/** 
+ * This function stores a list of new individuals in the nodes that own their positions, with
+ * one request per slave.
+ *
+ * @param x A vector containing the new individuals.
+ * @param first The global index of the first new individual.
+ * @param count The number of new individuals.
+ * @param newPopulation A vector containing the individuals of the new population of the master.
+ */
+void storeOffspringFM(chromosome_t x[][DIMENSION], popsize_t first, uint8_t count, population_t newPopulation[][POPULATION_COLUMNS])
+{
+	slave_t nodeId;
+	popsize_t index;
+	uint8_t c, n, k;
+	dimensionsize_t j;
+	
+	for(nodeId = 0; nodeId < NUM_NODES; nodeId++)
+	{
+		/* The positions are consecutive, so each node owns a range of them. */
+		for(c = 0, n = 0; c < count; c++)
+		{
+			n += (first + c >= partitionStart[nodeId] && first + c < partitionStart[nodeId + 1]);
+		}
+		
+		if(n == 0)
+		{
+			continue;
+		}
+		
+		if(nodeId == 0)
+		{
+			for(c = 0; c < count; c++)
+			{
+				index = first + c;
+				if(nodeOfIndexFM(partitionStart, &index) == 0)
+				{
+					for(j = 0; j < DIMENSION; j++)
+					{
+						SET_GENE(newPopulation, index, j, x[c][j]);
+					}
+				}
+			}
+			continue;
+		}
+		
+		/* The number of individuals goes along with the ACK. If they are lost, the slave keeps the
+		old individuals in these positions. */
+		if(!handshakeFM(nodeId, CMD_SEND_IND_BATCH, ACK_SEND_IND_BATCH, n, HANDSHAKE_TIMEOUT_MS))
+		{
+			continue;
+		}
+		
+		/* Send the position of the first individual (the next ones follow it) and then the individuals. */
+		for(c = 0, k = 0; c < count; c++)
+		{
+			index = first + c;
+			if(nodeOfIndexFM(partitionStart, &index) == nodeId)
+			{
+				if(k++ == 0)
+				{
+					SPDR = index;
+					while(!(SPSR & (1 << SPIF)));
+					(void) SPDR;
+				}
+				
+				spiWriteIndividualFM(x[c], 0, 0);
+			}
+		}
+		
+		/* Disable the selected slave */
+		deselectSlaveFM(nodeId);
+	}
+}
+
+#if STEADY_STATE
+
+/** 
+ * This function is run only by the master. It creates the new individuals of a steady-state step
+ * with the same tournaments and crossover of a generation and hands them to the nodes.
+ *
+ * @param evaluation A vector that stores the fitness values of the master.
+ * @param population A vector containing the individuals of the master.
+ */
+void steadySelectionFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS])
+{
+	/* Node and index (inside its node) of each contender. */
+	slave_t node[2 * STEADY_OFFSPRING];
+	popsize_t index[2 * STEADY_OFFSPRING];
+	chromosome_t individuals[STEADY_OFFSPRING][DIMENSION];
+	chromosome_t x, y;
+	slave_t i;
+	uint8_t c;
+	dimensionsize_t j;
+	
+	/* Move the individuals of the nodes that died to the healthy ones. The individuals are not moved
+	as a whole here, the positions a node gets start as its worst ones. */
+	if(healthChanged)
+	{
+		healthChanged = 0;
+		partitionFM();
+		
+		for(i = 1; i < NUM_NODES; i++)
+		{
+			sendPartitionFM(i, partitionStart[i + 1] - partitionStart[i]);
+		}
+		for(i = 0; i <= NUM_NODES; i++)
+		{
+			populationStart[i] = partitionStart[i];
+		}
+		resizePartitionFM(evaluation, population, partitionStart[1]);
+	}
+	
+	/* Randomly pick 2 contenders for each new individual and find the microcontrollers that store them. */
+	for(c = 0; c < 2 * STEADY_OFFSPRING; c++)
+	{
+		node[c] = drawIndividualFM(&index[c]);
+	}
+	
+	/* The tournaments are played as in a generation. */
+	tournamentsFM(evaluation, population, node, index, individuals, STEADY_OFFSPRING);
+	
+	/* Do the crossover of the individuals. */
+	for(c = 0; c < STEADY_OFFSPRING; c += 2)
+	{
+		for(j = 0; j < DIMENSION; j++)
+		{
+			/* Two chromosomes exchanges their genes between each other */
+			x = individuals[c][j];
+			y = individuals[c + 1][j];
+			individuals[c][j] = (x & MASK) | (y & ~MASK);
+			individuals[c + 1][j] = (x & ~MASK) | (y & MASK);
+		}
+	}
+	
+	mutateOffspringFM(individuals, STEADY_OFFSPRING);
+	
+	sendOffspringFM(individuals, STEADY_OFFSPRING);
+	
+	/* Continue operation in all slaves, each node evaluates its new individuals. */
+	continueAllOperationsFM();
+}
+
+#if MUTATION_SKIP
+
+/** 
+ * This function mutates a list of new individuals, as mutationFM does with a population.
+ *
+ * @param x A vector containing the new individuals.
+ * @param count The number of new individuals.
+ */
+void mutateOffspringFM(chromosome_t x[][DIMENSION], uint8_t count)
+{
+	uint8_t c;
+	uint32_t offset;
+	uint32_t limit;
+	uint16_t bit;
+	
+	/* The bits of the new individuals are numbered one after the other, as in mutationFM. */
+	limit = (uint32_t) count * INDIVIDUAL_BITS;
+	c = 0;
+	offset = mutationGapFM(limit);
+	
+	while(1)
+	{
+		while(offset >= INDIVIDUAL_BITS)
+		{
+			offset -= INDIVIDUAL_BITS;
+			if(++c >= count)
+			{
+				return;
+			}
+		}
+		
+		bit = (uint16_t) offset;
+		x[c][bit / CHROMOSOME_SIZE] ^= (chromosome_t) 1 << (bit % CHROMOSOME_SIZE);
+		
+		offset += 1 + mutationGapFM(limit);
+	}
+}
+
+#else
+
+/** 
+ * This function mutates a list of new individuals, as mutationFM does with a population.
+ *
+ * @param x A vector containing the new individuals.
+ * @param count The number of new individuals.
+ */
+void mutateOffspringFM(chromosome_t x[][DIMENSION], uint8_t count)
+{
+	uint8_t c;
+	dimensionsize_t j;
+	chromosomesize_t bitPosition;
+	
+	/* A generation mutates MUTATED_INDIVIDUALS of POPULATION_SIZE individuals, so each new one is
+	mutated with the same probability. */
+	for(c = 0; c < count; c++)
+	{
+		if(randomIndexFM(POPULATION_SIZE) >= MUTATED_INDIVIDUALS)
+		{
+			continue;
+		}
+		
+		for(j = 0; j < DIMENSION; j++)
+		{
+#if CHROMOSOME_SIZE & (CHROMOSOME_SIZE - 1)
+			bitPosition = ((uint16_t) random8() * CHROMOSOME_SIZE) >> 8;
+#else
+			bitPosition = random8() & (CHROMOSOME_SIZE-1);	
+#endif
+			x[c][j] ^= (chromosome_t) 1 << bitPosition;
+		}
+	}
+}
+
+#endif
+
+/** 
+ * This function hands a list of new individuals to random nodes (in proportion to their partitions),
+ * with one request per slave. The ones of the master are kept for replaceWorstFM.
+ *
+ * @param x A vector containing the new individuals.
+ * @param count The number of new individuals.
+ */
+void sendOffspringFM(chromosome_t x[][DIMENSION], uint8_t count)
+{
+	slave_t node[STEADY_OFFSPRING];
+	slave_t nodeId;
+	popsize_t index;
+	uint8_t c, n;
+	dimensionsize_t j;
+	
+	/* A random position picks the node, so faster nodes (with larger partitions) get more of them. */
+	for(c = 0; c < count; c++)
+	{
+		node[c] = drawIndividualFM(&index);
+		
+		if(node[c] == 0)
+		{
+			for(j = 0; j < DIMENSION; j++)
+			{
+				offspring[offspringCount][j] = x[c][j];
+			}
+			offspringCount++;
+		}
+	}
+	
+	for(nodeId = 1; nodeId < NUM_NODES; nodeId++)
+	{
+		for(c = 0, n = 0; c < count; c++)
+		{
+			n += (node[c] == nodeId);
+		}
+		
+		/* The number of individuals goes along with the ACK. If they are lost, the step just has
+		fewer new individuals. */
+		if(n == 0 || !handshakeFM(nodeId, CMD_SEND_IND_BATCH, ACK_SEND_IND_BATCH, n, HANDSHAKE_TIMEOUT_MS))
+		{
+			continue;
+		}
+		
+		for(c = 0; c < count; c++)
 		{
-			nodeChromosomeY1 = 1;
-			iChromosomeY1 -= POPULATION_SIZE/2; /* Calculate the relative index. */
+			if(node[c] == nodeId)
+			{
+				spiWriteIndividualFM(x[c], 0, 0);
+			}
 		}
-		if(iChromosomeY2 < POPULATION_SIZE/2)
+		
+		/* Disable the selected slave */
+		deselectSlaveFM(nodeId);
+	}
+}
+
+#endif
+
+#if CELLULAR
+
+/** 
+ * This function collects the first and the last row of the grid stored by a slave.
+ *
+ * @param nodeId The id of the slave.
+ * @param border A vector that will store the first row followed by the last one.
+ * @param fitness A vector that will store their fitness values.
+ * @return 1 if the slave answered or 0 otherwise.
+ */
+uint8_t collectBorderFM(slave_t nodeId, chromosome_t border[][DIMENSION], fitness_t fitness[])
+{
+	float_bytes received;
+	uint8_t c;
+	dimensionsize_t b;
+	
+	if(!handshakeFM(nodeId, CMD_COLLECT_BORDER, ACK_COLLECT_BORDER, DUMMY, HANDSHAKE_TIMEOUT_MS))
+	{
+		return 0;
+	}
+	
+	/* Each individual is followed by its fitness value (4 bytes). */
+	for(c = 0; c < 2 * CELL_WIDTH; c++)
+	{
+		spiReadIndividualFM(border[c], 0, 0);
+		for(b = 0; b < sizeof(float); b++)
 		{
-			nodeChromosomeY2 = 0;
-			/* iChromosomeY remains the same value. */
+			SPDR = DUMMY;
+			while(!(SPSR & (1 << SPIF)));
+			received.bytes[b] = SPDR;
 		}
-		else
-		{
-			nodeChromosomeY2 = 1;
-			iChromosomeY2 -= POPULATION_SIZE/2; /* Calculate the relative index. */
-		}		
-		
-		/* At this point, nodes and indexes were identified. Then, grab the evaluation values for each one. */
+		fitness[c] = received.value;
+	}
+	
+	/* Disable the selected slave */
+	deselectSlaveFM(nodeId);
+	
+	return 1;
+}
 
-		if (nodeChromosomeX1 == 0)
-		{
-			fitnessX1 = evaluation[iChromosomeX1];
-		}
-		else
+/** 
+ * This function sends a slave the rows of the grid next to its own (its halo).
+ *
+ * @param nodeId The id of the slave.
+ * @param above The last row of the previous node.
+ * @param aboveFitness The fitness values of the row above.
+ * @param below The first row of the next node.
+ * @param belowFitness The fitness values of the row below.
+ */
+void sendHaloFM(slave_t nodeId, chromosome_t above[][DIMENSION], fitness_t aboveFitness[], chromosome_t below[][DIMENSION], fitness_t belowFitness[])
+{
+	float_bytes sent;
+	uint8_t c;
+	dimensionsize_t b;
+	
+	/* If the halo is lost, the slave breeds its rows without the cells of its neighbours. */
+	if(!handshakeFM(nodeId, CMD_SEND_HALO, ACK_SEND_HALO, DUMMY, HANDSHAKE_TIMEOUT_MS))
+	{
+		return;
+	}
+	
+	/* Each individual is followed by its fitness value (4 bytes). */
+	for(c = 0; c < 2 * CELL_WIDTH; c++)
+	{
+		spiWriteIndividualFM((c < CELL_WIDTH) ? above[c] : below[c - CELL_WIDTH], 0, 0);
+		sent.value = (c < CELL_WIDTH) ? aboveFitness[c] : belowFitness[c - CELL_WIDTH];
+		for(b = 0; b < sizeof(float); b++)
 		{
-			fitnessX1 = collectEvaluationFM(nodeChromosomeX1, iChromosomeX1);
+			SPDR = sent.bytes[b];
+			while(!(SPSR & (1 << SPIF)));
+			(void) SPDR;
 		}
-		
-		if (nodeChromosomeX2 == 0)
+	}
+	
+	/* Disable the selected slave */
+	deselectSlaveFM(nodeId);
+}
+
+#endif
+
+/** 
+ * This function transfer the calibration time of a slave to the master.
+ *
+ * @param nodeId The id of the node to collect the calibration from.
+ * @returns The time the slave spent on its calibration (or a very long time if it did not answer).
+ */
+float collectCalibrationFM(slave_t nodeId)
+{
+	dimensionsize_t b;
+	float_bytes received;
+	
+	/* The slave does not answer while it is still measuring. */
+	if(!handshakeFM(nodeId, CMD_COLLECT_CALIBRATION, ACK_COLLECT_CALIBRATION, DUMMY, HANDSHAKE_TIMEOUT_MS))
+	{
+		return FITNESS_WORST;
+	}
+	
+	/* Now receive the 4 bytes. */
+	for(b = 0; b < sizeof(float); b++)
+	{
+		SPDR = DUMMY;
+		while(!(SPSR & (1 << SPIF)));
+		received.bytes[b] = SPDR;
+	}
+	
+	/* Disable the selected slave */
+	deselectSlaveFM(nodeId);
+	
+	return received.value;
+}
+
+/** 
+ * This function tells a slave how many individuals it stores.
+ *
+ * @param nodeId The id of the node.
+ * @param size The number of individuals of the node.
+ */
+void sendPartitionFM(slave_t nodeId, popsize_t size)
+{
+	dimensionsize_t b;
+	
+	if(!handshakeFM(nodeId, CMD_PARTITION, ACK_PARTITION, DUMMY, HANDSHAKE_TIMEOUT_MS))
+	{
+		return;
+	}
+	
+	/* Send the size, least significant byte first. */
+	for(b = 0; b < sizeof(popsize_t); b++)
+	{
+		SPDR = (spi_data_t) (size >> (8 * b));
+		while(!(SPSR & (1 << SPIF)));
+		(void) SPDR;
+	}
+	
+	/* Disable the selected slave */
+	deselectSlaveFM(nodeId);
+}
+
+#endif
+
+#else
+
+#if GA_MODE == GA_MODE_PARTITIONED
+
+/* This function is run only by the slave. It takes decisions based on the 
+command received in the first byte. */
+
+void selectionCrossoverProcessing(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], population_t newPopulation[][POPULATION_COLUMNS])
+{
+	command_t command;
+#if !PREFETCH_CONTENDERS
+	spi_data_t data;
+#endif
+	spi_data_t contenders[2];
+	uint8_t c, count;
+#if PREFETCH_CONTENDERS
+	uint8_t fetch;
+#endif
+	popsize_t index;
+	popsize_t size;
+#if !STEADY_STATE
+	popsize_t i;
+#endif
+#if !STEADY_STATE && !CELLULAR
+	dimensionsize_t j;
+#endif
+	float_bytes sent;
+#if CELLULAR
+	float_bytes received;
+#endif
+	dimensionsize_t b;
+#if INDIVIDUAL_COPY
+	chromosome_t x[DIMENSION];
+#endif
+	
+#if CELLULAR
+	/* If the master loses the halo, its cells never win a tournament. */
+	for(i = 0; i < 2 * CELL_WIDTH; i++)
+	{
+		haloFitness[i] = FITNESS_WORST;
+	}
+#elif !STEADY_STATE
+	/* If the master loses a new individual, the position keeps the current one. */
+	for(i = 0; i < nodePopulationSize; i++)
+	{
+		for(j = 0; j < DIMENSION; j++)
 		{
-			fitnessX2 = evaluation[iChromosomeX2];
+			SET_GENE(newPopulation, i, j, GET_GENE(population, i, j));
 		}
-		else
+	}
+#endif
+	
+	while(1) 
+	{
+#if BROADCAST_SELECT
+		/* The master may select all slaves at once, so wait with MISO tri-stated and the ready line released. */
+		DDRB &= ~(1 << MISO);
+		DDRD &= ~(1 << READY);
+#endif
+		command = waitCommandFM();
+#if BROADCAST_SELECT
+		DDRD |= (1 << READY);
+		if(command == CMD_BROADCAST_CONTINUE)
 		{
-			fitnessX2 = collectEvaluationFM(nodeChromosomeX2, iChromosomeX2);
+			/* Drive MISO again only when the master has deselected all slaves. */
+			while(!(PINB & (1 << SS2)));
+			DDRB |= (1 << MISO);
+			return;
 		}
+		DDRB |= (1 << MISO);
+#endif
 		
-		if (nodeChromosomeY1 == 0)
-		{
-			fitnessY1 = evaluation[iChromosomeY1];
-		}
-		else
+		/* Identify the command and take an action. */
+#if PREFETCH_CONTENDERS
+		if (command == CMD_COLLECT_CONTENDERS)
 		{
-			fitnessY1 = collectEvaluationFM(nodeChromosomeY1, iChromosomeY1);
+			/* Send the ACK and receive the number of requests. */
+			SPDR = ACK_COLLECT_CONTENDERS;
+			while(!(SPSR & (1 << SPIF)));
+			count = SPDR;
+			
+			/* Receive both indexes of the first request. */
+			for(c = 0; c < 2; c++)
+			{
+				while(!(SPSR & (1 << SPIF)));
+				contenders[c] = SPDR;
+			}
+			
+			/* Finally, send the winners, receiving the indexes of each next request along with the
+			winner of the previous one. Equal indexes ask for a contender of a tournament against
+			another node, which is followed by its fitness value (4 bytes). */
+			for(c = 0; c < count; c++)
+			{
+				/* The tournament method, as done by the master. */
+				fetch = (contenders[0] == contenders[1]);
+				index = (evaluation[contenders[0]] < evaluation[contenders[1]]) ? contenders[0] : contenders[1];
+				spiWriteIndividualFM(INDIVIDUAL(population, index, x), contenders, (c + 1 < count) ? 2 : 0);
+				
+				if(fetch)
+				{
+					sent.value = evaluation[index];
+					for(b = 0; b < sizeof(float); b++)
+					{
+						SPDR = sent.bytes[b];
+						while(!(SPSR & (1 << SPIF)));
+						(void) SPDR;
+					}
+				}
+			}
 		}
-		
-		if (nodeChromosomeY2 == 0)
+#else
+		if (command == CMD_COLLECT_EV_BATCH)
 		{
-			fitnessY2 = evaluation[iChromosomeY2];
+			/* Send the ACK and receive the number of indexes. */
+			SPDR = ACK_COLLECT_EV_BATCH;
+			while(!(SPSR & (1 << SPIF)));
+			count = SPDR;
+			
+			/* Receive the first index. */
+			while(!(SPSR & (1 << SPIF)));
+			index = SPDR;
+			
+			/* Finally, send the fitness values (4 bytes each), receiving each next index along
+			with the first byte of the previous value. */
+			for(c = 0; c < count; c++)
+			{
+				sent.value = evaluation[index];
+				for(b = 0; b < sizeof(float); b++)
+				{
+					SPDR = sent.bytes[b];
+					while(!(SPSR & (1 << SPIF)));
+					data = SPDR;
+					if(b == 0)
+					{
+						index = data;
+					}
+				}
+			}
 		}
-		else
+		else if (command == CMD_TOURNAMENT_BATCH)
 		{
-			fitnessY2 = collectEvaluationFM(nodeChromosomeY2, iChromosomeY2);
-		}
-
-		/* Now, do the tournament method. */
-		if (fitnessX1 < fitnessX2) {
-			iWinnerX = iChromosomeX1;
-			nodeWinnerX = nodeChromosomeX1;
+			/* Send the ACK and receive the number of tournaments. */
+			SPDR = ACK_TOURNAMENT_BATCH;
+			while(!(SPSR & (1 << SPIF)));
+			count = SPDR;
+			
+			/* Receive the indexes of both contenders of the first tournament. */
+			for(c = 0; c < 2; c++)
+			{
+				while(!(SPSR & (1 << SPIF)));
+				contenders[c] = SPDR;
+			}
+			
+			/* Finally, send the winners, receiving the contenders of each next tournament along
+			with the winner of the previous one. */
+			for(c = 0; c < count; c++)
+			{
+				/* The tournament method, as done by the master. */
+				index = (evaluation[contenders[0]] < evaluation[contenders[1]]) ? contenders[0] : contenders[1];
+				spiWriteIndividualFM(INDIVIDUAL(population, index, x), contenders, (c + 1 < count) ? 2 : 0);
+			}
 		}
-		else
+#endif
+		else if (command == CMD_SEND_IND_BATCH)
 		{
-			iWinnerX = iChromosomeX2;
-			nodeWinnerX = nodeChromosomeX2;
-		}
-		
-		if (fitnessY1 < fitnessY2) {
-			iWinnerY = iChromosomeY1;
-			nodeWinnerY = nodeChromosomeY1;
+			/* Send the ACK and receive the number of new individuals. */
+			SPDR = ACK_SEND_IND_BATCH;
+			while(!(SPSR & (1 << SPIF)));
+			count = SPDR;
+			
+#if STEADY_STATE
+			/* Receive them, they are evaluated and placed by replaceWorstFM. */
+			for(c = 0; c < count; c++)
+			{
+				spiReadIndividualFM(offspring[offspringCount++], 0, 0);
+			}
+#else
+			/* Receive the position of the first one. */
+			while(!(SPSR & (1 << SPIF)));
+			index = SPDR;
+			
+			/* Finally, receive the individuals, stored in consecutive positions. */
+			for(c = 0; c < count; c++)
+			{
+				spiReadIndividualFM(INDIVIDUAL(newPopulation, index + c, x), 0, 0);
+				STORE_INDIVIDUAL(newPopulation, index + c, x);
+			}
+#endif
 		}
-		else
+#if CELLULAR
+		else if (command == CMD_COLLECT_BORDER)
 		{
-			iWinnerY = iChromosomeY2;
-			nodeWinnerY = nodeChromosomeY2;
+			/* Send the ACK (the byte that goes along with it is not used). */
+			SPDR = ACK_COLLECT_BORDER;
+			while(!(SPSR & (1 << SPIF)));
+			(void) SPDR;
+			
+			/* Send the first and the last row, each individual followed by its fitness value. */
+			for(c = 0; c < 2 * CELL_WIDTH; c++)
+			{
+				index = (c < CELL_WIDTH) ? c : nodePopulationSize - 2 * CELL_WIDTH + c;
+				spiWriteIndividualFM(INDIVIDUAL(population, index, x), 0, 0);
+				sent.value = evaluation[index];
+				for(b = 0; b < sizeof(float); b++)
+				{
+					SPDR = sent.bytes[b];
+					while(!(SPSR & (1 << SPIF)));
+					(void) SPDR;
+				}
+			}
 		}
-		
-		/* If the node is the master, grab the individual directly. */
-		
-		if (nodeWinnerX == 0)
+		else if (command == CMD_SEND_HALO)
 		{
-			for(j = 0; j < DIMENSION; j++)
+			/* Send the ACK (the byte that goes along with it is not used). */
+			SPDR = ACK_SEND_HALO;
+			while(!(SPSR & (1 << SPIF)));
+			(void) SPDR;
+			
+			/* Receive the last row of the previous node and the first row of the next one. */
+			for(c = 0; c < 2 * CELL_WIDTH; c++)
 			{
-				winnerX[j] = population[iWinnerX][j];
+				spiReadIndividualFM(halo[c], 0, 0);
+				for(b = 0; b < sizeof(float); b++)
+				{
+					while(!(SPSR & (1 << SPIF)));
+					received.bytes[b] = SPDR;
+				}
+				haloFitness[c] = received.value;
 			}
 		}
-		else
-		{
-			collectIndividualFM(winnerX, nodeWinnerX, iWinnerX);
-		}		
-		
-		if (nodeWinnerY == 0)
+#endif
+		else if (command == CMD_PARTITION)
 		{
-			for(j = 0; j < DIMENSION; j++)
+			/* A node died and its individuals were moved to the other ones. */
+			size = receivePartitionFM();
+			
+#if STEADY_STATE || CELLULAR
+			resizePartitionFM(evaluation, population, size);
+#else
+			/* The positions this node did not store yet start with random individuals. */
+			for(i = nodePopulationSize; i < size; i++)
 			{
-				winnerY[j] = population[iWinnerY][j];
+				randomIndividualFM(newPopulation, i);
 			}
+			nodePopulationSize = size;
+#endif
 		}
-		else
+		else if (command == CMD_CONTINUE_OPERATIONS)
 		{
-			collectIndividualFM(winnerY, nodeWinnerY, iWinnerY);
+			/* Send the ACK. */
+			SPDR = ACK_CONTINUE_OPERATIONS;
+			while(!(SPSR & (1 << SPIF)));
+						
+			/* Read dummy byte (sent my master to receive the ack). */
+			command = SPDR;
+			
+			return;
 		}
-	
-		/* Do the crossover of the individuals. */
-		for(j = 0; j < DIMENSION; j++)
+		else if (command == CMD_SYNC)
 		{
-			/* Two chromosomes exchanges their genes between each other */
-			newIndX[j] = (winnerX[j] & MASK) | (winnerY[j] & ~MASK);
-			newIndY[j] = (winnerX[j] & ~MASK) | (winnerY[j] & MASK);
+			rejoinFM();
 		}
+	}
+}
+
+void waitSendBestIndividuaFM(population_t population[][POPULATION_COLUMNS])
+{
+	
+	command_t command;
+	uint8_t e;
+#if BEST_FITNESS_FIRST
+	uint8_t count;
+#endif
+	float_bytes sent;
+	dimensionsize_t b;
+#if INDIVIDUAL_COPY
+	chromosome_t x[DIMENSION];
+#endif
+		
+	while(1)
+	{	
+		SPDR = DUMMY;
+		command = waitCommandFM();
 				
-		/* Store the new individuals. */
-		if (i < POPULATION_SIZE/2) /* If replacing the first half (= master). */
+		if (command == CMD_COLLECT_BEST_IND)
 		{
-			for(j = 0; j < DIMENSION; j++)
-			{
-				newPopulation[i][j] = newIndX[j];
-				newPopulation[i+1][j] = newIndY[j];
-			}
+
+			SPDR = ACK_COLLECT_BEST_IND;
+			while(!(SPSR & (1 << SPIF)));
+			command = SPDR;
+			break;
 		}
-		else /* Remote uC. */
+		else if (command == CMD_SYNC)
 		{
-			sendIndividualFM(newIndX, 1);
-			sendIndividualFM(newIndY, 1);
+			rejoinFM();
 		}
-				
-#elif NUM_NODES == 4
-	/* TODO */
-#endif
-
 	}
 	
-	/* Continue operation in all slaves. */
-	for(i = 1; i < NUM_NODES; i++)
+#if BEST_FITNESS_FIRST
+	/* Finally, send the fitness values of the elites (the best one first). */
+	for(e = 0; e < ELITES; e++)
 	{
-		continueOperationsFM(i);
+		sent.value = eliteFitness[e];
+		for(b = 0; b < sizeof(float); b++)
+		{
+			SPDR = sent.bytes[b];
+			while(!(SPSR & (1 << SPIF)));
+			command = SPDR;
+		}
 	}
-}
-
-void continueOperationsFM(slave_t nodeId)
-{	
-	slave_select_t ss;
-	spi_data_t data;
 	
-	ss = 3 - nodeId;
+	/* The master answers how many of them enter the best individuals of the cluster, only these are sent. */
+	while(!(SPSR & (1 << SPIF)));
+	count = SPDR;
 	
-	while(1)
+	for(e = 0; e < count; e++)
 	{
-			
-		/* Enable the selected slave */
-		PORTB &= !(1 << ss);
-			
-		/* Send command and receive a response. */
-		SPDR = CMD_CONTINUE_OPERATIONS;
-		while(!(SPSR & (1 << SPIF)));
-		data = SPDR;
-			
-		_delay_ms(1);
-		SPDR = DUMMY;
-		while(!(SPSR & (1 << SPIF)));
-		data = SPDR;
-			
-		/* Disable the selected slave */
-		PORTB |= (1 << ss);
-			
-		/* Check if it received a ACK. */
-		if(data == ACK_CONTINUE_OPERATIONS)
+		spiWriteIndividualFM(INDIVIDUAL(population, eliteIndex[e], x), 0, 0);
+	}
+#else
+	/* Finally, send the elites (the best one first), each one after its fitness value. */
+	for(e = 0; e < ELITES; e++)
+	{
+		sent.value = eliteFitness[e];
+		for(b = 0; b < sizeof(float); b++)
 		{
-			break;
+			SPDR = sent.bytes[b];
+			while(!(SPSR & (1 << SPIF)));
+			command = SPDR;
 		}
-			
+		
+		spiWriteIndividualFM(INDIVIDUAL(population, eliteIndex[e], x), 0, 0);
 	}
+#endif
 }
 
-#else
-
-/* This function is run only by the slave. It takes decisions based on the 
-command received in the first byte. */
+#endif
 
-void selectionCrossoverProcessing(fitness_t evaluation[], chromosome_t population[][DIMENSION], chromosome_t newPopulation[][DIMENSION])
+/* This function is run only by the slave. It waits for the master and receives its partition size (or the checkpoint to resume from). */
+generationsize_t synchronizationFM(population_t population[][POPULATION_COLUMNS])
 {
-	
-	popsize_t counter; /* To count the number of individuals replaced. */
-	command_t command;
-	popsize_t index;
-	dimensionsize_t j;
-	float_bytes sent;
+	spi_data_t data;
+#if GA_MODE == GA_MODE_PARTITIONED && (CALIBRATE_PARTITIONS || CHECKPOINT_INTERVAL)
 	dimensionsize_t b;
+#endif
+#if GA_MODE == GA_MODE_PARTITIONED && CALIBRATE_PARTITIONS
+	float_bytes sent;
+#endif
+#if GA_MODE == GA_MODE_PARTITIONED && CHECKPOINT_INTERVAL
+	uint16_t epochs[CHECKPOINT_RECENT];
+	uint16_t generations[CHECKPOINT_RECENT];
+	uint16_t generation;
+	uint8_t s;
+#endif
+#if RANDOM_STREAMS
+	uint32_t seed;
+	uint8_t k;
+#endif
+#if GA_MODE != GA_MODE_PARTITIONED || !CHECKPOINT_INTERVAL
+	/* Only a resumed run loads the population here. */
+	(void) population;
+#endif
+
+	while(1)
+	{
+		data = waitCommandFM();
+		
+		if(data == CMD_SYNC)
+		{
+			SPDR = ACK_SYNC ;
+			while(!(SPSR & (1 << SPIF)));
+			break;
+		}
+	}
 	
-	counter = 0;
-	
-	while(1) 
+#if RANDOM_STREAMS
+	/* Read the parameter sent along with the ACK, then the seed of the cluster. */
+	data = SPDR;
+	seed = 0;
+	for(k = 0; k < sizeof(seed); k++)
 	{
 		while(!(SPSR & (1 << SPIF)));
-		command = SPDR;
+		data = SPDR;
+		seed |= (uint32_t) data << (8 * k);
+	}
+	seedFM(seed);
+#endif
+	
+#if LINK_CALIBRATION
+	/* The master tests the link before anything else. */
+	echoLinkTestsFM();
+#endif
+	
+#if GA_MODE == GA_MODE_PARTITIONED
+
+#if CALIBRATE_PARTITIONS
+	/* Measure while the master measures itself. */
+	sent.value = calibrationFM();
+#endif
+
+#if CHECKPOINT_INTERVAL
+	/* Check the checkpoints while the master synchronizes the other slaves. */
+	checkpoint_recent(epochs, generations);
+#endif
+	
+	while(1)
+	{
+		data = waitCommandFM();
 		
-		/* Identify the command and take an action. */
-		if (command == CMD_COLLECT_EV)
-		{			
+#if CALIBRATE_PARTITIONS
+		if(data == CMD_COLLECT_CALIBRATION)
+		{
 			/* Send the ACK. */
-			SPDR = ACK_COLLECT_EV;
-			while(!(SPSR & (1 << SPIF)));
-				
-			/* Read dummy byte (0x00) .*/
-			command = SPDR; // DUMMY
-				
-			/* Receive the index. */
+			SPDR = ACK_COLLECT_CALIBRATION;
 			while(!(SPSR & (1 << SPIF)));
-			index = SPDR;
-		
-			sent.value = evaluation[index];
+			
+			/* Read dummy byte (sent my master to receive the ack). */
+			data = SPDR;
 			
 			/* Finally, send the 4 bytes. */
 			for(b = 0; b < sizeof(float); b++)
 			{
-				/* Wait for transmission to complete */
 				SPDR = sent.bytes[b];
 				while(!(SPSR & (1 << SPIF)));
-				command = SPDR;
+				data = SPDR;
 			}
-		} 
-		else if (command == CMD_COLLECT_IND)
+		}
+		else
+#endif
+#if CHECKPOINT_INTERVAL
+		if(data == CMD_COLLECT_CHECKPOINT)
 		{
 			/* Send the ACK. */
-			SPDR = ACK_COLLECT_IND;
-			while(!(SPSR & (1 << SPIF)));
-							
-			/* Read dummy byte (sent my master to receive the ack). */
-			command = SPDR;
-							
-			/* Read index. */
+			SPDR = ACK_COLLECT_CHECKPOINT;
 			while(!(SPSR & (1 << SPIF)));
-			index = SPDR;
-			
 			
-#if CHROMOSOME_SIZE == 8
-
-			/* Finally, send the individual. */
-			for(j = 0; j < DIMENSION; j++)
-			{
-				/* Wait for transmission to complete */
-				SPDR = population[index][j];
-				while(!(SPSR & (1 << SPIF)));
-			}
+			/* Read dummy byte (sent my master to receive the ack). */
+			data = SPDR;
 			
-#elif CHROMOSOME_SIZE == 16
-
-			chromosome16_bytes temp;
-			dimensionsize_t k;
-
-			/* Finally, send the individual. */
-			for(j = 0; j < DIMENSION; j++)
+			/* Send the epoch and the generation of each checkpoint, least significant byte first. */
+			for(s = 0; s < CHECKPOINT_RECENT; s++)
 			{
-				temp.value = population[index][j];
-				
-				for(k = 0; k < 2; k++)
+				for(b = 0; b < 2; b++)
 				{
-					/* Wait for transmission to complete */
-					SPDR = temp.bytes[k];
+					SPDR = (spi_data_t) (epochs[s] >> (8 * b));
 					while(!(SPSR & (1 << SPIF)));
+					data = SPDR;
 				}
-			}
-#else 
-			chromosome32_bytes temp;
-			dimensionsize_t k;
-			
-			/* Finally, send the individual. */
-			for(j = 0; j < DIMENSION; j++)
-			{
-				temp.value = population[index][j];
-				
-				for(k = 0; k < 4; k++)
+				for(b = 0; b < 2; b++)
 				{
-					/* Wait for transmission to complete */
-					SPDR = temp.bytes[k];
+					SPDR = (spi_data_t) (generations[s] >> (8 * b));
 					while(!(SPSR & (1 << SPIF)));
+					data = SPDR;
 				}
 			}
-
-#endif					
-
-		}		
-		else if (command == CMD_SEND_IND)
+		}
+		else if(data == CMD_RESUME)
 		{
-
 			/* Send the ACK. */
-			SPDR = ACK_SEND_IND;
+			SPDR = ACK_RESUME;
 			while(!(SPSR & (1 << SPIF)));
-				
+			
 			/* Read dummy byte (sent my master to receive the ack). */
-			command = SPDR;
+			data = SPDR;
 			
-#if CHROMOSOME_SIZE == 8			
-		
-			/* Finally, receive the 4 bytes. */
-			for(j = 0; j < DIMENSION; j++)
+			/* Receive the epoch and the generation, least significant byte first. */
+			epoch = 0;
+			for(b = 0; b < 2; b++)
+			{
+				while(!(SPSR & (1 << SPIF)));
+				epoch |= (uint16_t) SPDR << (8 * b);
+			}
+			generation = 0;
+			for(b = 0; b < 2; b++)
 			{
-				/* Wait for transmission to complete */
-				SPDR = DUMMY;
 				while(!(SPSR & (1 << SPIF)));
-				newPopulation[counter][j] = SPDR;
+				generation |= (uint16_t) SPDR << (8 * b);
+			}
+			
+			/* Resuming keeps the partition of the checkpoint, so the master does not send it. */
+			if(generation != CHECKPOINT_NONE && resumeFM(population, generation))
+			{
+				return generation;
 			}
 			
-#elif CHROMOSOME_SIZE == 16
+			/* Otherwise, it is a new run and the master sends the partition next. */
+		}
+		else
+#endif
+		if(data == CMD_PARTITION)
+		{
+			nodePopulationSize = receivePartitionFM();
+			return 0;
+		}
+		else if(data == CMD_SYNC)
+		{
+			rejoinFM();
+		}
+	}
+	
+#endif
+
+	return 0;
+}
+
+#if GA_MODE == GA_MODE_PARTITIONED
+
+/** 
+ * This function is run only by the slave. It answers a CMD_PARTITION and receives the number of
+ * individuals this node stores.
+ *
+ * @return The number of individuals of this node.
+ */
+popsize_t receivePartitionFM(void)
+{
+	popsize_t size;
+	dimensionsize_t b;
+	
+	/* Send the ACK. */
+	SPDR = ACK_PARTITION;
+	while(!(SPSR & (1 << SPIF)));
+	
+	/* Read dummy byte (sent my master to receive the ack). */
+	(void) SPDR;
+	
+	/* Receive the size, least significant byte first. */
+	size = 0;
+	for(b = 0; b < sizeof(popsize_t); b++)
+	{
+		while(!(SPSR & (1 << SPIF)));
+		size |= (popsize_t) SPDR << (8 * b);
+	}
+	
+	return size;
+}
+
+#endif
+
+/* This function is run only by the slave. The master started a new run without this node (it
+was declared dead), so restart it through the watchdog and wait for the next synchronization. */
+void rejoinFM(void)
+{
+	wdt_enable(WDTO_15MS);
+	while(1);
+}
+
+/** 
+ * This function is run only by the slave. It waits for the next command of the master, at
+ * CPU_DIV_SLOW when POWER_SCALING is enabled, since the node has nothing else to do.
+ *
+ * @return The byte received.
+ */
+spi_data_t waitCommandFM(void)
+{
+#if POWER_SCALING
+	power_set_div(CPU_DIV_SLOW);
+#endif
+	
+	while(!(SPSR & (1 << SPIF)));
+	
+#if POWER_SCALING
+	power_set_div(CPU_DIV_FAST);
+#endif
+	
+	return SPDR;
+}
+
+#if LINK_CALIBRATION
+
+/* This function is run only by the slave, right after CMD_SYNC. It sends back the test individuals of
+the master until the master chooses the SPI clock of this link. */
+void echoLinkTestsFM(void)
+{
+	chromosome_t x[DIMENSION];
+	float_bytes received;
+	spi_data_t data;
+	dimensionsize_t b;
+	uint8_t k;
+	
+	while(1)
+	{
+		data = waitCommandFM();
+		
+		if(data == CMD_LINK_TEST)
+		{
+			/* Send the ACK. */
+			SPDR = ACK_LINK_TEST;
+			while(!(SPSR & (1 << SPIF)));
 			
-			chromosome16_bytes temp;
-			dimensionsize_t k;
+			/* Read dummy byte (sent my master to receive the ack). */
+			data = SPDR;
 			
-			/* Finally, receive the 4 bytes. */
-			for(j = 0; j < DIMENSION; j++)
+			/* Send back each individual through the same loops as the real transfers. At a clock too fast
+			for this node some bytes are lost and it falls behind, until the next handshakes clock it out. */
+			for(k = 0; k < LINK_TEST_INDIVIDUALS; k++)
 			{
-				for(k = 0; k < 2; k++)
+				spiReadIndividualFM(x, 0, 0);
+				for(b = 0; b < sizeof(float); b++)
 				{
-					SPDR = DUMMY;
 					while(!(SPSR & (1 << SPIF)));
-					temp.bytes[k] = SPDR;
+					received.bytes[b] = SPDR;
 				}
 				
-				newPopulation[counter][j] = temp.value;
-			}
-
-#else
-			chromosome32_bytes temp;
-			dimensionsize_t k;
-			
-			/* Finally, receive the 4 bytes. */
-			for(j = 0; j < DIMENSION; j++)
-			{
-				for(k = 0; k < 4; k++)
+				spiWriteIndividualFM(x, 0, 0);
+				for(b = 0; b < sizeof(float); b++)
 				{
-					SPDR = DUMMY;
+					SPDR = received.bytes[b];
 					while(!(SPSR & (1 << SPIF)));
-					temp.bytes[k] = SPDR;
+					(void) SPDR;
 				}
-				
-				newPopulation[counter][j] = temp.value;
 			}
-#endif	
-			counter++;
-		
 		}
-		else if (command == CMD_CONTINUE_OPERATIONS)
+		else if(data == CMD_LINK_DONE)
 		{
 			/* Send the ACK. */
-			SPDR = ACK_CONTINUE_OPERATIONS;
+			SPDR = ACK_LINK_DONE;
 			while(!(SPSR & (1 << SPIF)));
-						
+			
 			/* Read dummy byte (sent my master to receive the ack). */
-			command = SPDR;
+			data = SPDR;
 			
 			return;
 		}
+		else if(data == CMD_SYNC)
+		{
+			rejoinFM();
+		}
 	}
 }
 
-void waitSendBestIndividuaFM(chromosome_t population[][DIMENSION], popsize_t iBest)
+#endif
+
+/** 
+ * This function is run only by the workers (master-worker mode). It evaluates the batches streamed
+ * by the master until the master ends the run.
+ *
+ * @param evaluation A vector that will store the fitness values of the batch.
+ * @param population A vector that will store the individuals of the batch.
+ */
+void evaluationWorkerFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS])
 {
-	
 	command_t command;
-	dimensionsize_t j;
-		
+	popsize_t count;
+	popsize_t i;
+	float_bytes sent;
+	dimensionsize_t b;
+#if INDIVIDUAL_COPY
+	chromosome_t x[DIMENSION];
+#endif
+	
+	count = 0;
+	
 	while(1)
-	{	
-		SPDR = DUMMY;
-		while(!(SPSR & (1 << SPIF)));
-		command = SPDR;
-				
-		if (command == CMD_COLLECT_BEST_IND)
+	{
+#if BROADCAST_SELECT
+		/* The master may select all slaves at once, so wait with MISO tri-stated and the ready line released. */
+		DDRB &= ~(1 << MISO);
+		DDRD &= ~(1 << READY);
+#endif
+		command = waitCommandFM();
+#if BROADCAST_SELECT
+		DDRD |= (1 << READY);
+		if(command == CMD_BROADCAST_CONTINUE)
 		{
-
-			SPDR = ACK_COLLECT_BEST_IND;
-			while(!(SPSR & (1 << SPIF)));
-			command = SPDR;
-			break;
+			/* Drive MISO again only when the master has deselected all slaves. */
+			while(!(PINB & (1 << SS2)));
+			DDRB |= (1 << MISO);
+			return;
 		}
-	}
-							
-#if CHROMOSOME_SIZE == 8
-
-	/* Finally, send the individual. */
-	for(j = 0; j < DIMENSION; j++)
-	{
-		/* Wait for transmission to complete */
-		SPDR = population[iBest][j];
-		while(!(SPSR & (1 << SPIF)));
-	}
-			
-#elif CHROMOSOME_SIZE == 16
-
-	chromosome16_bytes temp;
-	dimensionsize_t k;
-
-	/* Finally, send the individual. */
-	for(j = 0; j < DIMENSION; j++)
-	{
-		temp.value = population[iBest][j];
-								
-		for(k = 0; k < 2; k++)
+		DDRB |= (1 << MISO);
+#endif
+		
+		if(command == CMD_EVALUATE_BATCH)
 		{
-			/* Wait for transmission to complete */
-			SPDR = temp.bytes[k];
+			/* Send the ACK and receive the size of the batch. */
+			SPDR = ACK_EVALUATE_BATCH;
 			while(!(SPSR & (1 << SPIF)));
+			count = SPDR;
+			
+			/* Receive the individuals. */
+			for(i = 0; i < count; i++)
+			{
+				spiReadIndividualFM(INDIVIDUAL(population, i, x), 0, 0);
+				STORE_INDIVIDUAL(population, i, x);
+			}
+			
+			/* The master is not waiting for this, it collects the result later. */
+			evaluateRangeFM(evaluation, population, 0, count);
 		}
-	}
-#else
-	chromosome32_bytes temp;
-	dimensionsize_t k;
+		else if(command == CMD_COLLECT_BATCH)
+		{
+			/* Send the ACK. */
+			SPDR = ACK_COLLECT_BATCH;
+			while(!(SPSR & (1 << SPIF)));
 			
-	/* Finally, send the individual. */
-	for(j = 0; j < DIMENSION; j++)
-	{
-		temp.value = population[iBest][j];
-				
-		for(k = 0; k < 4; k++)
+			/* Read dummy byte (sent my master to receive the ack). */
+			command = SPDR;
+			
+			/* Finally, send 4 bytes per individual. */
+			for(i = 0; i < count; i++)
+			{
+				sent.value = evaluation[i];
+				for(b = 0; b < sizeof(float); b++)
+				{
+					SPDR = sent.bytes[b];
+					while(!(SPSR & (1 << SPIF)));
+					command = SPDR;
+				}
+			}
+		}
+		else if(command == CMD_CONTINUE_OPERATIONS)
 		{
-			/* Wait for transmission to complete */
-			SPDR = temp.bytes[k];
+			/* Send the ACK. */
+			SPDR = ACK_CONTINUE_OPERATIONS;
 			while(!(SPSR & (1 << SPIF)));
+			
+			/* Read dummy byte (sent my master to receive the ack). */
+			command = SPDR;
+			
+			return;
+		}
+		else if(command == CMD_SYNC)
+		{
+			rejoinFM();
 		}
 	}
-
-#endif
-		
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -3,29 +3,187 @@
 
 #include <stdint.h>
 
+/* Distribution models. */
+#define GA_MODE_PARTITIONED 0 /* Each node stores and evaluates a partition of the population. */
+#define GA_MODE_MASTER_WORKER 1 /* The master stores the population, the slaves only evaluate. */
+
+/* Population layouts. */
+#define LAYOUT_AOS 0 /* One array per individual (the genes of an individual are contiguous). */
+#define LAYOUT_SOA 1 /* One array per dimension (the same gene of all individuals is contiguous). */
+
 /* Configuration of the Genetic Algorithm */
 
-#define CHROMOSOME_SIZE 16 /* 8, 16 or 32 */
+#define CHROMOSOME_SIZE 16 /* Bits of each gene, between 1 and 32 (genes of other sizes than 8, 16 or 32 are packed) */
+#define CROSSOVER_POINT (CHROMOSOME_SIZE / 2) /* The crossover swaps the bits of the genes from this one up, between 0 and CHROMOSOME_SIZE - 1 */
 #define DIMENSION 1 /* Dimension of the chromosome */
 #define POPULATION_SIZE 32 /* 16, 32, 64, 128 or 256 */
 #define NUM_GENERATIONS 64 /* Between 1 and 256 */
-#define MUTATED_INDIVIDUALS 2 /* Between 0 and POPULATION_SIZE. */
+#define MUTATED_INDIVIDUALS 2 /* Between 0 and POPULATION_SIZE - ELITES. */
+#define ELITES 1 /* Best individuals of each node kept in the next generation (without evaluating them again) and sent to the master at the end, between 1 and 32. */
+#define MUTATION_SKIP 0 /* 1 to flip each bit of the new individuals with probability MUTATION_RATE instead of one bit per gene of MUTATED_INDIVIDUALS individuals. */
+#define MUTATION_RATE 0.002 /* Probability of flipping each bit (MUTATION_SKIP only), between 0 and 1. */
+#define MUTATION_TABLE 16 /* Entries of the tables used to draw the gaps between flipped bits (2, 4, 8, 16, 32 or 64). */
 #define NORMALIZATION_MIN 0.0 /* Min limit for the result */
 #define NORMALIZATION_MAX 1.0 /* Max limit for the result */
+#define POPULATION_LAYOUT LAYOUT_AOS /* LAYOUT_AOS or LAYOUT_SOA */
 
 /* Configuration of the distributed system. */
 #define NUM_NODES 2 /* Number of microcontrollers, including the master */
 #define NODE_ID 1 /* 0 means it's the master */
+#define GA_MODE GA_MODE_PARTITIONED /* GA_MODE_PARTITIONED or GA_MODE_MASTER_WORKER */
+#define EVALUATION_BATCH_SIZE 4 /* Individuals evaluated by a worker at once (master-worker mode). */
+#define SELECTION_BATCH 16 /* Pairs of new individuals the master schedules at once (partitioned mode), each one needs 4 draws. */
+#define PREFETCH_CONTENDERS STEADY_STATE /* 1 to fetch both contenders of a tournament between nodes with their fitness values in one request (it pays off for small batches, 0 asks for the fitness values first and for the winners later). */
+#define BEST_FITNESS_FIRST 0 /* 1 to collect the fitness values of the elites of each slave at the end of a run before its individuals, so only the ones that enter the ELITES best are sent (it pays off for long chromosomes). */
+#define STEADY_STATE 0 /* 1 to replace the worst individuals of the nodes by STEADY_OFFSPRING new ones at each step instead of renewing the whole population every generation (partitioned mode). */
+#define STEADY_OFFSPRING 4 /* New individuals of each step (STEADY_STATE only), even and between 2 and 2 * SELECTION_BATCH. */
+#define CELLULAR 0 /* 1 to arrange the population in a torus grid split in rows between the nodes, with each parent picked among the neighbours of its cell (partitioned mode). */
+#define CELL_WIDTH 4 /* Columns of the grid (CELLULAR only), between 1 and 64, POPULATION_SIZE must be a multiple of it. */
+
+/* Configuration of the population partitions. */
+#define NODE_WEIGHTS {1, 1} /* Relative speed of each node, the master first (NUM_NODES values). */
+#define CALIBRATE_PARTITIONS 0 /* 1 to measure the speed of each node at CMD_SYNC instead of using NODE_WEIGHTS. */
+#define CALIBRATION_EVALUATIONS 1 /* Evaluations timed by each node when calibrating. */
+#define MASTER_LOAD_PERCENT 75 /* Share of its measured speed used by the master (it also selects and communicates). */
+#define PARTITION_HEADROOM 0 /* 1 to let each node store up to 1.5 times its even share, so uneven NODE_WEIGHTS are followed and the healthy nodes take the individuals of a dead one (it costs RAM and EEPROM, CALIBRATE_PARTITIONS always enables it). */
+
+/* Configuration of consecutive runs. */
+#define WARM_START 0 /* 1 to start each run from the final population of the previous one (and skip CMD_SYNC). */
+#define WARM_IMMIGRANTS 2 /* Random individuals inserted by each node in a warm start. */
+#define CHECKPOINT_INTERVAL 0 /* Generations between EEPROM checkpoints, used to resume a run after a reset (0 disables them). */
+
+/* Configuration of the fault tolerance. */
+#define HANDSHAKE_TIMEOUT_MS 10000 /* Time a slave has to answer a command, it must cover how long a slave can lag behind the master. */
+#define SYNC_TIMEOUT_MS 5000 /* Time a slave has to answer CMD_SYNC, it must cover a reboot. */
+#define NODE_MAX_MISSES 2 /* Handshakes a slave can miss in a row before it is declared dead. */
+
+/* Configuration of the SPI link. */
+#define LINK_CALIBRATION 1 /* 1 to find the fastest reliable SPI clock of each slave at CMD_SYNC (0 keeps fosc/128). */
+#define LINK_TEST_INDIVIDUALS 4 /* Individuals (each one with a fitness value) sent to each slave and back at each SPI clock (between 1 and 16). */
+#define LINK_MARGIN 2 /* Clock steps (each one halves the clock) kept below the fastest clock without errors (the transfers have no CRC). */
+#define BROADCAST_SELECT 0 /* 1 to release all slaves with one command sent to every slave-select line at once and to wait for them on the ready line (PD6, see README). */
+
+/* Configuration of the random generators. */
+#define RANDOM_STREAMS 1 /* 1 to give each node its own xoshiro128** stream of the seed the master sends at CMD_SYNC (0 keeps the LFSRs seeded in main.c). */
+#define RANDOM_SEED 96233 /* Seed of the master, the seed of each run is drawn from it and sent to the slaves at CMD_SYNC. */
 
 /*  DO NOT EDIT ANYTHING BELLOW THIS POINT */
 
 /* Cluster configuration */
-#if NUM_NODES != 2 && NUM_NODES != 4
-	#error "NUM_NODES must be 2 or 4"
+#if NUM_NODES < 2 || NUM_NODES > 4
+	#error "NUM_NODES must be between 2 and 4"
+#endif
+
+#if LINK_CALIBRATION && (LINK_TEST_INDIVIDUALS < 1 || LINK_TEST_INDIVIDUALS > 16)
+	#error "LINK_TEST_INDIVIDUALS must be between 1 and 16"
 #endif
 
-#define NODE_POPULATION_SIZE (POPULATION_SIZE/NUM_NODES)
-#define NODE_MUTATED_INDIVIDUALS (MUTATED_INDIVIDUALS/NUM_NODES)
+#if GA_MODE == GA_MODE_MASTER_WORKER
+
+	/* The master stores the whole population and the workers a single batch. */
+	#if NODE_ID == 0
+		#define NODE_POPULATION_MAX POPULATION_SIZE
+	#else
+		#define NODE_POPULATION_MAX EVALUATION_BATCH_SIZE
+	#endif
+	
+	#define NODE_MUTATED_INDIVIDUALS MUTATED_INDIVIDUALS
+	
+	#if ELITES + MUTATED_INDIVIDUALS > POPULATION_SIZE
+		#error "ELITES + MUTATED_INDIVIDUALS must not exceed POPULATION_SIZE"
+	#endif
+	
+	#if EVALUATION_BATCH_SIZE < 1 || EVALUATION_BATCH_SIZE > 127 /* It is sent along with an ACK (see handshakeFM). */
+		#error "EVALUATION_BATCH_SIZE must be between 1 and 127"
+	#endif
+
+#elif GA_MODE == GA_MODE_PARTITIONED
+
+	#define NODE_MUTATED_INDIVIDUALS (MUTATED_INDIVIDUALS/NUM_NODES)
+	
+	/* The elites are kept in the first positions and never mutated. */
+	#define NODE_POPULATION_MIN (NODE_MUTATED_INDIVIDUALS + ELITES + 1)
+	
+	/* Partitions are made of PARTITION_UNIT individuals (whole rows of the grid in the cellular GA). */
+	#if CELLULAR
+		#define PARTITION_UNIT CELL_WIDTH
+	#else
+		#define PARTITION_UNIT 1
+	#endif
+	
+	/* Individuals each node can store. Without headroom it is the even share, so the partitions can
+	only be even (the population shrinks if a node dies). */
+	#if PARTITION_HEADROOM || CALIBRATE_PARTITIONS
+		#define NODE_POPULATION_MAX (3*POPULATION_SIZE/(2*NUM_NODES))
+	#else
+		#define NODE_POPULATION_MAX ((POPULATION_SIZE/PARTITION_UNIT + NUM_NODES - 1)/NUM_NODES*PARTITION_UNIT)
+	#endif
+	
+	#define PARTITION_MIN ((NODE_POPULATION_MIN + PARTITION_UNIT - 1) / PARTITION_UNIT)
+	#define PARTITION_MAX (NODE_POPULATION_MAX / PARTITION_UNIT)
+	
+	#if NODE_POPULATION_MAX * NUM_NODES < POPULATION_SIZE
+		#error "NODE_POPULATION_MAX is too small to store the population"
+	#endif
+	
+	#if NODE_POPULATION_MIN * NUM_NODES > POPULATION_SIZE
+		#error "POPULATION_SIZE is too small for NUM_NODES"
+	#endif
+	
+	#if SELECTION_BATCH < 1 || SELECTION_BATCH > 47 /* Up to 4 * SELECTION_BATCH draws are sent along with an ACK, below 0xC0 (see handshakeFM). */
+		#error "SELECTION_BATCH must be between 1 and 47"
+	#endif
+
+#else
+	#error "GA_MODE must be GA_MODE_PARTITIONED or GA_MODE_MASTER_WORKER"
+#endif
+
+#if ELITES < 1 || ELITES > 32
+	#error "ELITES must be between 1 and 32"
+#endif
+
+#if STEADY_STATE
+	#if GA_MODE != GA_MODE_PARTITIONED
+		#error "STEADY_STATE requires GA_MODE_PARTITIONED"
+	#endif
+	
+	#if STEADY_OFFSPRING < 2 || STEADY_OFFSPRING > 2 * SELECTION_BATCH || (STEADY_OFFSPRING & 1)
+		#error "STEADY_OFFSPRING must be even and between 2 and 2 * SELECTION_BATCH"
+	#endif
+	
+	/* Steps of each generation, so a generation still evaluates about POPULATION_SIZE new individuals. */
+	#define STEADY_STEPS (POPULATION_SIZE / STEADY_OFFSPRING)
+#endif
+
+#if CELLULAR
+	#if GA_MODE != GA_MODE_PARTITIONED || STEADY_STATE
+		#error "CELLULAR requires GA_MODE_PARTITIONED without STEADY_STATE"
+	#endif
+	
+	#if CELL_WIDTH < 1 || CELL_WIDTH > 64 || POPULATION_SIZE % CELL_WIDTH
+		#error "CELL_WIDTH must be between 1 and 64 and divide POPULATION_SIZE"
+	#endif
+	
+	#if PARTITION_MAX * PARTITION_UNIT * NUM_NODES < POPULATION_SIZE
+		#error "NODE_POPULATION_MAX is too small to store the rows of the grid"
+	#endif
+	
+	#if PARTITION_MIN * PARTITION_UNIT * NUM_NODES > POPULATION_SIZE
+		#error "POPULATION_SIZE has too few rows for NUM_NODES"
+	#endif
+	
+	/* Cells of a neighbourhood: the cell itself and the ones above, below, left and right of it. */
+	#define CELL_NEIGHBOURS 5
+#endif
+
+#if MUTATION_SKIP && (MUTATION_TABLE < 2 || MUTATION_TABLE > 64 || (MUTATION_TABLE & (MUTATION_TABLE - 1)))
+	#error "MUTATION_TABLE must be 2, 4, 8, 16, 32 or 64"
+#endif
+
+/* Health of the nodes. */
+#define NODE_ALIVE 0
+#define NODE_SUSPECT 1 /* It missed a handshake. */
+#define NODE_DEAD 2 /* It missed NODE_MAX_MISSES handshakes in a row, its individuals are moved to the other nodes. */
 
 typedef uint8_t slave_t;
 typedef uint8_t command_t;
@@ -36,29 +194,40 @@ typedef uint8_t spi_data_t;
 
 #define MASK_SIZE CHROMOSOME_SIZE
 
-#if CHROMOSOME_SIZE == 8
-
+#if CHROMOSOME_SIZE >= 1 && CHROMOSOME_SIZE <= 8
 	typedef uint8_t chromosome_t;
-	#define MASK 0xF0
-	#define NORMALIZED_GAIN ((NORMALIZATION_MAX - NORMALIZATION_MIN)/255.0)
-
-#elif CHROMOSOME_SIZE == 16
-
+#elif CHROMOSOME_SIZE > 8 && CHROMOSOME_SIZE <= 16
 	typedef uint16_t chromosome_t;
-	#define MASK 0xFF00
-	#define NORMALIZED_GAIN ((NORMALIZATION_MAX - NORMALIZATION_MIN)/65535.0)
+#elif CHROMOSOME_SIZE > 16 && CHROMOSOME_SIZE <= 32
+	typedef uint32_t chromosome_t;
+#else
+	#error "CHROMOSOME_SIZE must be between 1 and 32"
+#endif
+
+#if CROSSOVER_POINT < 0 || CROSSOVER_POINT >= CHROMOSOME_SIZE
+	#error "CROSSOVER_POINT must be between 0 and CHROMOSOME_SIZE - 1"
+#endif
 
-#elif CHROMOSOME_SIZE == 32
+/* Largest gene and bits of a gene taken from the first parent by the crossover. */
+#define GENE_MAX (0xFFFFFFFFUL >> (32 - CHROMOSOME_SIZE))
+#define MASK ((chromosome_t) (GENE_MAX & ~((1UL << CROSSOVER_POINT) - 1)))
+#define NORMALIZED_GAIN ((NORMALIZATION_MAX - NORMALIZATION_MIN)/(double) GENE_MAX)
 
-	typedef uint32_t chromosome_t;
-	#define MASK 0xFFFF0000
-	#define NORMALIZED_GAIN ((NORMALIZATION_MAX - NORMALIZATION_MIN)/4294967295.0) 
-	
+/* Genes that do not fill a chromosome_t are packed one after the other (least significant bit first)
+in vectors of bytes, so they do not waste memory. The SPI always sends the genes packed this way. */
+#if CHROMOSOME_SIZE == 8 || CHROMOSOME_SIZE == 16 || CHROMOSOME_SIZE == 32
+	#define PACKED_GENES 0
+	typedef chromosome_t population_t;
 #else
-	#error "CHROMOSOME_SIZE must be 8, 16 or 32"
+	#define PACKED_GENES 1
+	typedef uint8_t population_t;
 #endif
 
 /* Population configuration */
+#define INDIVIDUAL_BITS (DIMENSION * CHROMOSOME_SIZE)
+#define INDIVIDUAL_BYTES ((INDIVIDUAL_BITS + 7) / 8)
+#define GENE_BYTES(n) (((n) * CHROMOSOME_SIZE + 7) / 8) /* Bytes of n packed genes. */
+
 typedef uint8_t dimensionsize_t;
 typedef uint8_t chromosomesize_t;
 
@@ -74,10 +243,74 @@ typedef uint8_t generationsize_t;
 typedef uint16_t generationsize_t;
 #endif
 
+/* Population layout: populations are declared as population_t population[POPULATION_ROWS][POPULATION_COLUMNS],
+GET_GENE and SET_GENE give access to the gene j of the individual i. INDIVIDUAL gives the genes of an individual
+as a vector (the individual itself or a copy in x) and STORE_INDIVIDUAL writes x back, which is needed only for a
+copy (INDIVIDUAL_COPY). */
+#if POPULATION_LAYOUT == LAYOUT_AOS
+
+	#define POPULATION_ROWS NODE_POPULATION_MAX
+	#define GENE_ROW(i, j) (i)
+	#define GENE_COLUMN(i, j) (j)
+	#if PACKED_GENES
+		#define POPULATION_COLUMNS INDIVIDUAL_BYTES
+	#else
+		#define POPULATION_COLUMNS DIMENSION
+	#endif
+
+#elif POPULATION_LAYOUT == LAYOUT_SOA
+
+	#define POPULATION_ROWS DIMENSION
+	#define GENE_ROW(i, j) (j)
+	#define GENE_COLUMN(i, j) (i)
+	#if PACKED_GENES
+		#define POPULATION_COLUMNS GENE_BYTES(NODE_POPULATION_MAX)
+	#else
+		#define POPULATION_COLUMNS NODE_POPULATION_MAX
+	#endif
+
+#else
+	#error "POPULATION_LAYOUT must be LAYOUT_AOS or LAYOUT_SOA"
+#endif
+
+#if PACKED_GENES
+	#define GET_GENE(population, i, j) readGeneFM((population)[GENE_ROW(i, j)], (uint16_t) GENE_COLUMN(i, j) * CHROMOSOME_SIZE)
+	#define SET_GENE(population, i, j, value) writeGeneFM((population)[GENE_ROW(i, j)], (uint16_t) GENE_COLUMN(i, j) * CHROMOSOME_SIZE, value)
+	#define POPULATION_BYTES (POPULATION_ROWS * POPULATION_COLUMNS)
+#else
+	#define GET_GENE(population, i, j) ((population)[GENE_ROW(i, j)][GENE_COLUMN(i, j)])
+	#define SET_GENE(population, i, j, value) ((population)[GENE_ROW(i, j)][GENE_COLUMN(i, j)] = (value))
+	#define POPULATION_BYTES (POPULATION_ROWS * POPULATION_COLUMNS * (CHROMOSOME_SIZE / 8))
+#endif
+
+#if POPULATION_LAYOUT == LAYOUT_AOS && !PACKED_GENES
+	#define INDIVIDUAL_COPY 0
+	#define INDIVIDUAL(population, i, x) ((population)[i])
+	#define STORE_INDIVIDUAL(population, i, x)
+#else
+	#define INDIVIDUAL_COPY 1
+	#define INDIVIDUAL(population, i, x) loadIndividualFM(population, i, x)
+	#define STORE_INDIVIDUAL(population, i, x) storeIndividualFM(population, i, x)
+#endif
+
+/* Checkpoint configuration: random generators, partition size, layout (master) and population. */
+#if RANDOM_STREAMS
+	#define RANDOM_STATE_BYTES 16
+#else
+	#define RANDOM_STATE_BYTES 8
+#endif
+#define CHECKPOINT_BYTES (RANDOM_STATE_BYTES + 2 + 2 * (NUM_NODES + 1) + POPULATION_BYTES)
+
 /* Fitness configuration */
 typedef float fitness_t;
 typedef float normalization_t;
 
+/* Fitness given to the individuals that could not be collected (never wins a tournament). */
+#define FITNESS_WORST 3.4e38
+
+/* Number of individuals stored in this node (its partition of the population). */
+extern popsize_t nodePopulationSize;
+
 /* Functions definitions */
 
 /** 
@@ -88,24 +321,150 @@ typedef float normalization_t;
  * @param population A vector containing the individuals.
  * @return The index of the best individual in the population after the last generation.
  */
-popsize_t geneticAlgorithmFM(fitness_t evaluation[], chromosome_t population[][DIMENSION]);
+popsize_t geneticAlgorithmFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS]);
 
 /** 
  * This function initializes the population with random individuals. It should be called once.
  *
  * @param population A vector containing the individuals.
  */
-void initializationFM(chromosome_t population[][DIMENSION]);
+void initializationFM(population_t population[][POPULATION_COLUMNS]);
+
+/** 
+ * This function generates a random individual.
+ *
+ * @param population A vector containing the individuals.
+ * @param i The index of the individual to be generated.
+ */
+void randomIndividualFM(population_t population[][POPULATION_COLUMNS], popsize_t i);
+
+#if INDIVIDUAL_COPY
+
+/** 
+ * This function copies the genes of an individual to a vector (see INDIVIDUAL).
+ *
+ * @param population A vector containing the individuals.
+ * @param i The index of the individual.
+ * @param x A vector that will store the genes.
+ * @return The vector x.
+ */
+chromosome_t *loadIndividualFM(population_t population[][POPULATION_COLUMNS], popsize_t i, chromosome_t x[]);
+
+/** 
+ * This function copies a vector to the genes of an individual (see STORE_INDIVIDUAL).
+ *
+ * @param population A vector containing the individuals.
+ * @param i The index of the individual.
+ * @param x A vector containing the genes.
+ */
+void storeIndividualFM(population_t population[][POPULATION_COLUMNS], popsize_t i, chromosome_t x[]);
+
+#endif
+
+#if PACKED_GENES
+
+/** 
+ * This function reads a packed gene (see GET_GENE).
+ *
+ * @param bytes A vector of packed genes.
+ * @param bit The position of the first bit of the gene.
+ * @return The gene.
+ */
+chromosome_t readGeneFM(population_t bytes[], uint16_t bit);
+
+/** 
+ * This function writes a packed gene (see SET_GENE). The other bits of the vector are kept.
+ *
+ * @param bytes A vector of packed genes.
+ * @param bit The position of the first bit of the gene.
+ * @param value The gene (it must fit in CHROMOSOME_SIZE bits).
+ */
+void writeGeneFM(population_t bytes[], uint16_t bit, chromosome_t value);
+
+/** 
+ * This function packs the genes of an individual in a vector of bytes (the unused bits are cleared).
+ *
+ * @param x A vector containing the genes.
+ * @param packed A vector that will store the INDIVIDUAL_BYTES bytes.
+ */
+void packIndividualFM(chromosome_t x[], population_t packed[]);
+
+/** 
+ * This function unpacks the genes of an individual from a vector of bytes.
+ *
+ * @param packed A vector containing the INDIVIDUAL_BYTES bytes.
+ * @param x A vector that will store the genes.
+ */
+void unpackIndividualFM(population_t packed[], chromosome_t x[]);
+
+#endif
+
+#if WARM_START
+
+/** 
+ * This function reseeds the population from the final population of the previous run. The elites
+ * keep their positions (their cells in CELLULAR mode) and the last WARM_IMMIGRANTS other individuals
+ * are replaced by random ones, so the population can follow an objective that drifted.
+ *
+ * @param population A vector containing the individuals of the previous run.
+ */
+void warmStartFM(population_t population[][POPULATION_COLUMNS]);
+
+#endif
 
 /** 
  * This function calculates the fitness value for the whole population. Before that, the
- * individuals are normalized to a range where the solution might be in.
+ * individuals are normalized to a range where the solution might be in. It also finds the
+ * ELITES best individuals in the same pass.
  *
  * @param evaluation A vector that will store the fitness values for the individuals.
  * @param population A vector containing the individuals.
+ * @param first The index of the first individual to be evaluated (the ones before it are elites whose fitness is known).
+ * In CELLULAR mode, the elites keep their cells, so any value above 0 only skips the cells of the elites.
  * @return The index of the best individual in the population after the last generation.
  */
-popsize_t fitnessFM(fitness_t evaluation[], chromosome_t population[][DIMENSION]);
+popsize_t fitnessFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], popsize_t first);
+
+/** 
+ * This function finds the ELITES best individuals of the population from their fitness values.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ * @return The index of the best individual in the population.
+ */
+popsize_t elitesFM(fitness_t evaluation[]);
+
+/** 
+ * This function finds where a fitness value enters a list of the best ones, sorted from the best
+ * one. A value equal to others goes after them.
+ *
+ * @param best A vector with the fitness values of the list.
+ * @param count The number of values in the list (up to ELITES).
+ * @param value The fitness value.
+ * @return The position of the value or ELITES if it does not enter a full list.
+ */
+uint8_t elitePositionFM(fitness_t best[], uint8_t count, fitness_t value);
+
+#if CELLULAR || WARM_START
+
+/** 
+ * This function checks if a position (a cell in CELLULAR mode) holds one of the elites of this node.
+ *
+ * @param i The index of the position.
+ * @return 1 if the position holds an elite or 0 otherwise.
+ */
+uint8_t isEliteFM(popsize_t i);
+
+#endif
+
+/** 
+ * This function normalizes and evaluates a range of individuals.
+ *
+ * @param evaluation A vector that will store the fitness values for the individuals.
+ * @param population A vector containing the individuals.
+ * @param first The index of the first individual to be evaluated.
+ * @param count The number of individuals to be evaluated.
+ */
+void evaluateRangeFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], popsize_t first, popsize_t count);
 
 /** 
  * This function normalizes an individual to an specified range (between NORMALIZATION_MIN and NORMALIZATION_MAX).
@@ -122,25 +481,148 @@ void normalizationFM(chromosome_t chromesome[], normalization_t normalizedChrome
  *
  * @param evaluation A vector that stores the fitness values of the individuals.
  * @param population A vector containing the individuals.
- * @param The index of the best individual in the population after the generation of the new population.
  */
-void newPopulationFM(fitness_t evaluation[], chromosome_t population[][DIMENSION], popsize_t iBest);
+void newPopulationFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS]);
 
 /** 
  * This function mutates some individuals of the population.
  *
  * @param newPopulation A vector containing the individuals.
  */
-void mutationFM(chromosome_t newPopulation[][DIMENSION]);
+void mutationFM(population_t newPopulation[][POPULATION_COLUMNS]);
+
+#if MUTATION_SKIP
+
+/** 
+ * This function fills the tables used by mutationGapFM. A gap G between flipped bits follows a
+ * geometric distribution, which is split as G = MUTATION_TABLE * Q + R: Q (full chunks of bits) and
+ * R (bits in the last chunk) are drawn from the cumulative distributions stored in the tables.
+ */
+void mutationTableFM(void);
+
+/** 
+ * This function finds the first entry of a table above a random number.
+ *
+ * @param table A cumulative distribution (MUTATION_TABLE entries).
+ * @param u A random number.
+ * @return The index of the entry (MUTATION_TABLE if u is above all entries).
+ */
+uint8_t mutationSearchFM(uint16_t table[], uint16_t u);
+
+/** 
+ * This function draws the number of bits skipped before the next flipped bit.
+ *
+ * @param limit The gap is not drawn further than this number of bits.
+ * @return The number of bits to skip (at least limit if the next flipped bit is beyond it).
+ */
+uint32_t mutationGapFM(uint32_t limit);
+
+#endif
 
 /** 
- * This function replaced the old population by the new one.
+ * This function replaced the old population by the new one. The elites of the old population are
+ * kept in the first positions (in their own cells in CELLULAR mode), along with their fitness values.
  *
+ * @param evaluation A vector that stores the fitness values of the individuals.
  * @param population A vector containing the old individuals.
  * @param newPopulation A vector containing the new individuals.
- * @param iBest The index of the best individual in the population.
  */
-void updateFM(chromosome_t population[][DIMENSION], chromosome_t newPopulation[][DIMENSION], popsize_t iBest);
+void updateFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], population_t newPopulation[][POPULATION_COLUMNS]);
+
+#if STEADY_STATE
+
+/** 
+ * This function runs one step of the steady-state GA. The master creates STEADY_OFFSPRING new
+ * individuals and hands them to the nodes, and then each node evaluates only the ones it got.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ * @param population A vector containing the individuals.
+ */
+void steadyStateFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS]);
+
+/** 
+ * This function evaluates the new individuals this node got in the current step. Each one replaces
+ * the worst individual of the node if it is better.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ * @param population A vector containing the individuals.
+ */
+void replaceWorstFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS]);
+
+/** 
+ * This function builds the heap of the individuals of this node, the worst one on top.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ */
+void worstHeapFM(fitness_t evaluation[]);
+
+/** 
+ * This function moves an entry of the heap down until the entries below it are not worse.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ * @param h The position of the entry in the heap.
+ */
+void worstSiftFM(fitness_t evaluation[], popsize_t h);
+
+#endif
+
+#if STEADY_STATE || CELLULAR
+
+/** 
+ * This function changes the number of individuals of this node. The new positions start with random
+ * individuals marked as the worst ones, so they are the first to be replaced.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ * @param population A vector containing the individuals.
+ * @param size The new number of individuals.
+ */
+void resizePartitionFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], popsize_t size);
+
+#endif
+
+#if CELLULAR
+
+/** 
+ * This function breeds the rows of the grid stored by this node. The parents of each cell are the
+ * winners of two tournaments between random cells of its neighbourhood, and the first individual of
+ * their crossover takes the position of the cell. The elites keep their cells.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ * @param population A vector containing the individuals.
+ * @param newPopulation A vector that will store the new individuals.
+ */
+void cellularSelectionFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], population_t newPopulation[][POPULATION_COLUMNS]);
+
+/** 
+ * This function finds a cell of the neighbourhood of another one. The columns wrap around inside the
+ * node, while the rows above the first one and below the last one are in the halo.
+ *
+ * @param cell The index of the cell.
+ * @param n The neighbour, between 0 and CELL_NEIGHBOURS - 1.
+ * @return The index of the neighbour (from -CELL_WIDTH for the halo above to nodePopulationSize + CELL_WIDTH - 1 for the halo below).
+ */
+int16_t cellNeighbourFM(popsize_t cell, uint8_t n);
+
+/** 
+ * This function gets the fitness value of a cell, which may be in the halo.
+ *
+ * @param evaluation A vector that stores the fitness values of the individuals.
+ * @param p The index of the cell (see cellNeighbourFM).
+ * @return The fitness value of the cell.
+ */
+fitness_t cellFitnessFM(fitness_t evaluation[], int16_t p);
+
+/** 
+ * This function gets a gene of a cell, which may be in the halo.
+ *
+ * @param population A vector containing the individuals.
+ * @param p The index of the cell (see cellNeighbourFM).
+ * @param j The gene.
+ * @return The gene of the cell.
+ */
+chromosome_t cellGeneFM(population_t population[][POPULATION_COLUMNS], int16_t p, dimensionsize_t j);
+
+#endif
 
 /*
  * This function evaluates and generates a fitness value of the invididual, that has to
@@ -153,31 +635,68 @@ fitness_t evaluationFM(normalization_t xn[]);
 
 
 /** 
- * This function transfer one individual from slave to master.
+ * This function writes one individual to the SPI, least significant byte first. It is used by the
+ * master to send and by the slaves to answer (in this case the master clocks the bytes). The bytes
+ * received at the same time are stored in a vector (the ones that do not fit follow the individual).
  *
  * @param x A vector representing a multi-dimension individual.
- * @param nodeId The id of the node to collect the individual from.
- * @param index The index of the individual to be collected.
+ * @param in A vector that will store the bytes received along with the individual.
+ * @param count The number of bytes to be received (0 to discard them).
  */
-void collectIndividualFM(chromosome_t x[], slave_t  nodeId, popsize_t index);
+void spiWriteIndividualFM(chromosome_t x[], spi_data_t in[], uint8_t count);
 
+/** 
+ * This function reads one individual from the SPI, least significant byte first. The bytes of a
+ * vector are sent at the same time instead of dummy bytes (the ones that do not fit follow the individual).
+ *
+ * @param x A vector that will store the individual.
+ * @param out A vector containing the bytes to be sent along with the individual.
+ * @param count The number of bytes to be sent (0 to send only dummy bytes).
+ */
+void spiReadIndividualFM(chromosome_t x[], spi_data_t out[], uint8_t count);
 
 /** 
- * This function transfer one evaluation value from slave to master.
+ * This function synchronizes the nodes before the GA starts. The master also decides how many individuals
+ * each node stores and sends the partition sizes to the slaves (it has different implementations for master and slaves).
+ * After a reset, the nodes may resume from a checkpoint instead.
  *
- * @param nodeId The id of the node to collect the individual from.
- * @param index The index of the individual to be collected.
- * @return value The evaluation value for the individual in position index.
+ * @param population A vector that will store the individuals of a resumed run.
+ * @return The generation to resume from (0 to start a new run).
  */
-float collectEvaluationFM(slave_t nodeId, popsize_t index);
+generationsize_t synchronizationFM(population_t population[][POPULATION_COLUMNS]);
 
 /** 
- * This function transfer one individual from master to slave.
+ * This function saves the state of this node (random generators, partition and population) in the EEPROM.
  *
- * @param x A vector representing a multi-dimension individual.
- * @param nodeId The id of the node to send the individual to.
+ * @param population A vector containing the individuals.
+ * @param generation The number of generations already run.
  */
-void sendIndividualFM(chromosome_t x[], slave_t nodeId);
+void checkpointFM(population_t population[][POPULATION_COLUMNS], generationsize_t generation);
+
+/** 
+ * This function restores the state of this node from a checkpoint of the current epoch.
+ *
+ * @param population A vector that will store the individuals.
+ * @param generation The generation of the checkpoint.
+ * @return 1 if the checkpoint was restored or 0 if it was not found.
+ */
+uint8_t resumeFM(population_t population[][POPULATION_COLUMNS], generationsize_t generation);
+
+/** 
+ * This function seeds the random generator of this node. With RANDOM_STREAMS, every node jumps
+ * NODE_ID times from the same seed, so the nodes draw from disjoint streams of the cluster seed.
+ *
+ * @param seed The seed of the cluster.
+ */
+void seedFM(uint32_t seed);
+
+/** 
+ * This function measures how long this node takes to evaluate an individual. It is used
+ * to size the partitions when CALIBRATE_PARTITIONS is enabled.
+ *
+ * @return The time spent by CALIBRATION_EVALUATIONS evaluations (in seconds).
+ */
+float calibrationFM(void);
 
 /** 
  * This function processes the selection and crossover (it has different implementations for master and slaves).
@@ -186,18 +705,65 @@ void sendIndividualFM(chromosome_t x[], slave_t nodeId);
  * @param population A vector containing the individuals.
  * @param newPopulation A vector containing the individuals of the new population. 
  */
-void selectionCrossoverProcessing(fitness_t evaluation[], chromosome_t population[][DIMENSION], chromosome_t newPopulation[][DIMENSION]);
+void selectionCrossoverProcessing(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], population_t newPopulation[][POPULATION_COLUMNS]);
 
 
 #if NODE_ID == 0
 /** 
- * This function is run by the master and collects the best individuals of all slaves.
+ * This function selects a slave.
+ *
+ * @param nodeId The id of the node.
+ */
+void selectSlaveFM(slave_t nodeId);
+
+/** 
+ * This function deselects a slave.
+ *
+ * @param nodeId The id of the node.
+ */
+void deselectSlaveFM(slave_t nodeId);
+
+/** 
+ * This function draws a random index between 0 and n - 1. Indexes are drawn from the smallest
+ * power of two not below n and rejected until they fit, so every index is equally likely.
+ *
+ * @param n The number of indexes (between 1 and POPULATION_SIZE).
+ * @return The random index.
+ */
+popsize_t randomIndexFM(popsize_t n);
+
+/** 
+ * This function checks if all slaves answered their last handshake.
+ *
+ * @return 1 if all slaves are alive or 0 otherwise.
+ */
+uint8_t slavesAliveFM(void);
+
+/** 
+ * This function sends a command to a slave until it answers with the expected ACK or the timeout
+ * expires. A node that misses NODE_MAX_MISSES handshakes in a row is declared dead and its
+ * individuals are moved to the other nodes in the next generation.
+ *
+ * @param nodeId The id of the node.
+ * @param command The command.
+ * @param ack The ACK expected for the command.
+ * @param parameter The first byte of the payload, sent while the ACK is received (DUMMY if there
+ * is none). It must be below 0xC0, since a busy slave takes the last byte it received as a command.
+ * @param timeout The time the slave has to answer (in ms).
+ * @return 1 if the slave answered (it is left selected for the payload) or 0 otherwise.
+ */
+uint8_t handshakeFM(slave_t nodeId, command_t command, spi_data_t ack, spi_data_t parameter, uint16_t timeout);
+
+/** 
+ * This function is run by the master and collects the elites of all slaves. It keeps the ELITES
+ * best individuals of all microcontrollers, the elites of the master included. Each slave sends
+ * the fitness values of its elites with them, so they are not evaluated again.
  *
- * @param bestIndividuals A vector that stores the best individuals of all microcontrollers.
+ * @param bestIndividuals A vector that will store the ELITES best individuals (the best one first).
+ * @param bestFitness A vector that will store their fitness values.
  * @param population A vector containing the individuals.
- * @param iBest Index of the best individual in master node.
  */
-void collectBestIndividualsFM(chromosome_t bestIndividuals[][DIMENSION], chromosome_t population[][DIMENSION], popsize_t iBest);
+void collectBestIndividualsFM(chromosome_t bestIndividuals[][DIMENSION], fitness_t bestFitness[], population_t population[][POPULATION_COLUMNS]);
 
 
 /** 
@@ -207,14 +773,317 @@ void collectBestIndividualsFM(chromosome_t bestIndividuals[][DIMENSION], chromos
  */
 void continueOperationsFM(slave_t nodeId);
 
+/** 
+ * This function is run by the master to tell all slaves to continue their operations. With
+ * BROADCAST_SELECT, they are released by a single broadcast once the ready line shows that all of
+ * them wait for a command, otherwise each one gets its own handshake.
+ */
+void continueAllOperationsFM(void);
+
+#if BROADCAST_SELECT
+
+/** 
+ * This function waits until all slaves wait for a command. Each slave holds the ready line low
+ * while it is busy, so the line only goes high when the last one is ready. The line is only used
+ * while all slaves are alive, since a slave that hangs may hold it low.
+ *
+ * @param timeout The time the slaves have to get ready (in ms).
+ * @return 1 if all slaves are ready or 0 otherwise.
+ */
+uint8_t slavesReadyFM(uint16_t timeout);
+
+/** 
+ * This function sends a command to all healthy slaves at once, with all their slave-select lines
+ * asserted. The slaves keep MISO tri-stated while they wait for a command, so it has no ACK and
+ * it must only be sent when all of them are ready (see slavesReadyFM).
+ *
+ * @param command The command.
+ */
+void broadcastFM(command_t command);
+
+#endif
+
+/** 
+ * This function splits the population between the healthy nodes proportionally to their speed
+ * (nodeSpeed). Each partition stays between NODE_POPULATION_MIN and NODE_POPULATION_MAX individuals,
+ * so the population shrinks if the healthy nodes cannot store POPULATION_SIZE individuals. Every
+ * partition is a multiple of PARTITION_UNIT individuals.
+ */
+void partitionFM(void);
+
+/** 
+ * This function finds the node that stores a given individual.
+ *
+ * @param start The layout of the population (index of the first individual of each node).
+ * @param index The global index of the individual. It is replaced by the index inside the node.
+ * @return The id of the node that stores the individual.
+ */
+slave_t nodeOfIndexFM(popsize_t start[], popsize_t *index);
+
+/** 
+ * This function randomly picks an individual of the current population that is stored in a healthy node.
+ *
+ * @param index It will store the index of the individual inside its node.
+ * @return The id of the node that stores the individual.
+ */
+slave_t drawIndividualFM(popsize_t *index);
+
+/** 
+ * This function plays a list of tournaments between individuals of any node. Tournament t is played
+ * between contenders 2t and 2t + 1, and when both are stored by the same slave, it is left to that slave.
+ *
+ * @param evaluation A vector that stores the fitness values of the master.
+ * @param population A vector containing the individuals of the master.
+ * @param node The node that stores each contender (it may be changed).
+ * @param index The index of each contender inside its node (it may be changed).
+ * @param winners A vector that will store the winner of each tournament.
+ * @param count The number of tournaments.
+ */
+void tournamentsFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], slave_t node[], popsize_t index[], chromosome_t winners[][DIMENSION], uint8_t count);
+
+#if PREFETCH_CONTENDERS
+
+/** 
+ * This function collects a list of tournament contenders, with one request per slave. A tournament
+ * between two individuals of the same slave is a single request with both indexes, and the slave
+ * sends back the winner. Each contender of a tournament against another node is a request with its
+ * index twice, and the slave sends it back followed by its fitness value.
+ *
+ * @param evaluation A vector that stores the fitness values of the master.
+ * @param population A vector containing the individuals of the master.
+ * @param node The node that stores each contender.
+ * @param index The index of each contender inside its node.
+ * @param x A vector that will store the contenders (the winner in place of the first one for the tournaments inside a slave).
+ * @param fitness A vector that will store their fitness values (FITNESS_WORST if the slave did not answer).
+ * @param count The number of contenders.
+ */
+void collectContendersFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS], slave_t node[], popsize_t index[], chromosome_t x[][DIMENSION], fitness_t fitness[], uint8_t count);
+
 #else
+
 /** 
- * This function is run by the slaves and busy wait to send the best individual to master.
+ * This function collects the fitness values of a list of tournament contenders, with one request per
+ * slave. The values of contenders whose opponent (c xor 1) is stored by the same slave are not collected.
+ *
+ * @param evaluation A vector that stores the fitness values of the master.
+ * @param node The node that stores each individual.
+ * @param index The index of each individual inside its node.
+ * @param fitness A vector that will store the fitness values (FITNESS_WORST if the slave did not answer).
+ * @param count The number of individuals.
+ */
+void collectFitnessFM(fitness_t evaluation[], slave_t node[], popsize_t index[], fitness_t fitness[], uint8_t count);
+
+/** 
+ * This function collects the winners of a list of tournaments, with one request per slave. Tournament t
+ * is played between individuals index[2t] and index[2t + 1] of node[2t] (both indexes are the same if
+ * the master already knows the winner), and the slave sends back only the winner.
+ *
+ * @param population A vector containing the individuals of the master.
+ * @param node The node that stores the contenders of each tournament.
+ * @param index The indexes of the contenders inside their node.
+ * @param x A vector that will store the winners (the best one of the master if the slave did not answer).
+ * @param count The number of tournaments.
+ */
+void collectWinnersFM(population_t population[][POPULATION_COLUMNS], slave_t node[], popsize_t index[], chromosome_t x[][DIMENSION], uint8_t count);
+
+#endif
+
+/** 
+ * This function stores a list of new individuals in the nodes that own their positions, with
+ * one request per slave.
+ *
+ * @param x A vector containing the new individuals.
+ * @param first The global index of the first new individual.
+ * @param count The number of new individuals.
+ * @param newPopulation A vector containing the individuals of the new population of the master.
+ */
+void storeOffspringFM(chromosome_t x[][DIMENSION], popsize_t first, uint8_t count, population_t newPopulation[][POPULATION_COLUMNS]);
+
+#if STEADY_STATE
+
+/** 
+ * This function is run only by the master. It creates the new individuals of a steady-state step
+ * with the same tournaments and crossover of a generation and hands them to the nodes.
+ *
+ * @param evaluation A vector that stores the fitness values of the master.
+ * @param population A vector containing the individuals of the master.
+ */
+void steadySelectionFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS]);
+
+/** 
+ * This function mutates a list of new individuals, as mutationFM does with a population.
+ *
+ * @param x A vector containing the new individuals.
+ * @param count The number of new individuals.
+ */
+void mutateOffspringFM(chromosome_t x[][DIMENSION], uint8_t count);
+
+/** 
+ * This function hands a list of new individuals to random nodes (in proportion to their partitions),
+ * with one request per slave. The ones of the master are kept for replaceWorstFM.
+ *
+ * @param x A vector containing the new individuals.
+ * @param count The number of new individuals.
+ */
+void sendOffspringFM(chromosome_t x[][DIMENSION], uint8_t count);
+
+#endif
+
+#if CELLULAR
+
+/** 
+ * This function collects the first and the last row of the grid stored by a slave.
+ *
+ * @param nodeId The id of the slave.
+ * @param border A vector that will store the first row followed by the last one.
+ * @param fitness A vector that will store their fitness values.
+ * @return 1 if the slave answered or 0 otherwise.
+ */
+uint8_t collectBorderFM(slave_t nodeId, chromosome_t border[][DIMENSION], fitness_t fitness[]);
+
+/** 
+ * This function sends a slave the rows of the grid next to its own (its halo).
+ *
+ * @param nodeId The id of the slave.
+ * @param above The last row of the previous node.
+ * @param aboveFitness The fitness values of the row above.
+ * @param below The first row of the next node.
+ * @param belowFitness The fitness values of the row below.
+ */
+void sendHaloFM(slave_t nodeId, chromosome_t above[][DIMENSION], fitness_t aboveFitness[], chromosome_t below[][DIMENSION], fitness_t belowFitness[]);
+
+#endif
+
+/** 
+ * This function is run only by the master. In the first run after a reset, it looks for the newest
+ * checkpoint saved by all nodes and tells them to resume from it. Otherwise, it starts a new epoch
+ * (which is only stored in the EEPROM along with the checkpoints of the run).
+ *
+ * @param population A vector that will store the individuals.
+ * @return The generation to resume from (0 to start a new run).
+ */
+generationsize_t agreeCheckpointFM(population_t population[][POPULATION_COLUMNS]);
+
+/** 
+ * This function collects the newest checkpoints (epoch and generation) of a slave.
+ *
+ * @param nodeId The id of the node.
+ * @param epochs A vector that will store the epoch of each checkpoint.
+ * @param generations A vector that will store the generation of each checkpoint (CHECKPOINT_NONE if there are fewer).
+ * @return 1 if the checkpoints were collected or 0 if the slave did not answer.
+ */
+uint8_t collectCheckpointsFM(slave_t nodeId, uint16_t epochs[], uint16_t generations[]);
+
+/** 
+ * This function tells a slave the epoch of the run and the checkpoint to resume from.
+ *
+ * @param nodeId The id of the node.
+ * @param generation The generation of the checkpoint (CHECKPOINT_NONE to start a new run).
+ */
+void sendResumeFM(slave_t nodeId, uint16_t generation);
+
+/** 
+ * This function transfer the calibration time of a slave to the master.
+ *
+ * @param nodeId The id of the node to collect the calibration from.
+ * @returns The time the slave spent on its calibration (or a very long time if it did not answer).
+ */
+float collectCalibrationFM(slave_t nodeId);
+
+/** 
+ * This function tells a slave how many individuals it stores.
+ *
+ * @param nodeId The id of the node.
+ * @param size The number of individuals of the node.
+ */
+void sendPartitionFM(slave_t nodeId, popsize_t size);
+
+/** 
+ * This function streams a batch of individuals from master to a worker, which starts evaluating them.
+ *
+ * @param population A vector containing the individuals.
+ * @param first The index of the first individual of the batch.
+ * @param count The number of individuals (up to EVALUATION_BATCH_SIZE).
+ * @param nodeId The id of the worker.
+ * @return 1 if the batch was sent or 0 if the worker did not answer.
+ */
+uint8_t sendBatchFM(population_t population[][POPULATION_COLUMNS], popsize_t first, popsize_t count, slave_t nodeId);
+
+/** 
+ * This function collects the fitness values of the last batch sent to a worker. It waits
+ * until the worker finishes the evaluation.
+ *
+ * @param evaluation A vector that will store the fitness values.
+ * @param count The number of individuals of the batch.
+ * @param nodeId The id of the worker.
+ * @return 1 if the values were collected or 0 if the worker did not answer.
+ */
+uint8_t collectBatchFM(fitness_t evaluation[], popsize_t count, slave_t nodeId);
+
+/** 
+ * This function finds the SPI clock used with a slave. Starting from the slowest clock, it tests
+ * each faster one until the first test fails, then it keeps LINK_MARGIN steps below the last clock that passed.
+ *
+ * @param nodeId The id of the node.
+ */
+void calibrateLinkFM(slave_t nodeId);
+
+/** 
+ * This function sends LINK_TEST_INDIVIDUALS known individuals (each one followed by a fitness value) to a
+ * slave at a given SPI clock and reads them back. Both sides use the same loops as the real transfers, so
+ * the test includes the time each node needs between bytes.
+ *
+ * @param nodeId The id of the node.
+ * @param setting The SPI clock setting (SPI_CLOCK_FASTEST to SPI_CLOCK_SLOWEST).
+ * @return 1 if all individuals came back or 0 otherwise.
+ */
+uint8_t testLinkFM(slave_t nodeId, uint8_t setting);
+
+#else
+/** 
+ * This function is run by the slaves and busy wait to send their ELITES best individuals to master
+ * (the best one first) with their fitness values.
  *
  * @param population A vector containing the individuals.
- * @param iBest Index of the best individual in slave node.
  */
-void waitSendBestIndividuaFM(chromosome_t population[][DIMENSION], popsize_t iBest);
+void waitSendBestIndividuaFM(population_t population[][POPULATION_COLUMNS]);
+
+/** 
+ * This function is run only by the workers (master-worker mode). It evaluates the batches streamed
+ * by the master until the master ends the run.
+ *
+ * @param evaluation A vector that will store the fitness values of the batch.
+ * @param population A vector that will store the individuals of the batch.
+ */
+void evaluationWorkerFM(fitness_t evaluation[], population_t population[][POPULATION_COLUMNS]);
+
+/** 
+ * This function is run only by the slave. It answers a CMD_PARTITION and receives the number of
+ * individuals this node stores.
+ *
+ * @return The number of individuals of this node.
+ */
+popsize_t receivePartitionFM(void);
+
+/** 
+ * This function is run only by the slave. The master started a new run without this node (it
+ * was declared dead), so restart it through the watchdog and wait for the next synchronization.
+ */
+void rejoinFM(void);
+
+/** 
+ * This function is run only by the slave. It waits for the next command of the master, at
+ * CPU_DIV_SLOW when POWER_SCALING is enabled, since the node has nothing else to do.
+ *
+ * @return The byte received.
+ */
+spi_data_t waitCommandFM(void);
+
+/** 
+ * This function is run only by the slave, right after CMD_SYNC. It sends back the test individuals of
+ * the master until the master chooses the SPI clock of this link.
+ */
+void echoLinkTestsFM(void);
 
 #endif
 
@@ -0,0 +1,383 @@
+#include "host.h"
+#include "kernels.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Phases that draw random numbers, each one seeds its own streams. */
+#define PHASE_INITIALIZATION 0
+#define PHASE_SELECTION 1
+
+#define HOST_BLOCKS ((HOST_POPULATION_SIZE + HOST_BLOCK - 1) / HOST_BLOCK)
+
+/* State shared by the threads. */
+typedef struct {
+	fitness_t *evaluation;
+	chromosome_t (*population)[DIMENSION];
+	chromosome_t (*newPopulation)[DIMENSION];
+	hostsize_t best[HOST_THREADS]; /* Best individual found by each thread. */
+	pthread_barrier_t barrier;
+} host_shared;
+
+typedef struct {
+	host_shared *shared;
+	uint32_t id;
+} host_worker;
+
+/**
+ * This function evaluates the blocks of a thread.
+ *
+ * @param evaluation A vector that will store the fitness values.
+ * @param population A vector containing the individuals.
+ * @param id The id of the thread.
+ * @return The index of the best individual of these blocks (the first one if there is a tie).
+ */
+static hostsize_t hostFitnessFM(fitness_t evaluation[], chromosome_t population[][DIMENSION], uint32_t id)
+{
+	hostsize_t block, i, last, iBest;
+	normalization_t normalizedChromosome[DIMENSION];
+	dimensionsize_t j;
+
+	iBest = HOST_POPULATION_SIZE;
+	for(block = id; block < HOST_BLOCKS; block += HOST_THREADS)
+	{
+		last = (block == HOST_BLOCKS - 1) ? HOST_POPULATION_SIZE : (block + 1) * HOST_BLOCK;
+		for(i = block * HOST_BLOCK; i < last; i++)
+		{
+			for(j = 0; j < DIMENSION; j++)
+			{
+				normalizedChromosome[j] = NORMALIZATION_MIN + ((normalization_t) NORMALIZED_GAIN) * population[i][j];
+			}
+			evaluation[i] = evaluationFM(normalizedChromosome);
+
+			if(iBest == HOST_POPULATION_SIZE || evaluation[i] < evaluation[iBest])
+			{
+				iBest = i;
+			}
+		}
+	}
+
+	return iBest;
+}
+
+/**
+ * This function generates the new individuals of a block: tournaments between two random
+ * individuals, crossover of each pair of winners and the mutation of one bit per gene of the
+ * individuals 1 to HOST_MUTATED_INDIVIDUALS (the first one is replaced by the best individual).
+ * The winners are gathered first so crossover and mutation run over whole blocks of genes.
+ *
+ * @param evaluation A vector that stores the fitness values.
+ * @param population A vector containing the individuals.
+ * @param newPopulation A vector that will store the new individuals.
+ * @param x A buffer of HOST_BLOCK individuals (the genes that give the bits of MASK).
+ * @param y A buffer of HOST_BLOCK individuals (the other genes, later the mutation masks).
+ * @param pool The random pool of the thread.
+ * @param generation The generation.
+ * @param block The index of the block.
+ */
+static void hostNewBlockFM(fitness_t evaluation[], chromosome_t population[][DIMENSION], chromosome_t newPopulation[][DIMENSION],
+	chromosome_t x[][DIMENSION], chromosome_t y[][DIMENSION], hostpool_t *pool, uint32_t generation, hostsize_t block)
+{
+	hostsize_t i, first, last, a, b, iWinnerX, iWinnerY;
+	dimensionsize_t j;
+
+	hostSeedFM(pool, generation, PHASE_SELECTION, block);
+	first = block * HOST_BLOCK;
+	last = (block == HOST_BLOCKS - 1) ? HOST_POPULATION_SIZE : first + HOST_BLOCK;
+
+	for(i = 0; first + i < last; i += 2)
+	{
+		/* Randomly pick 4 individuals and keep the 2 winners. */
+		a = hostRandomIndexFM(pool, HOST_POPULATION_SIZE);
+		b = hostRandomIndexFM(pool, HOST_POPULATION_SIZE);
+		iWinnerX = (evaluation[a] < evaluation[b]) ? a : b;
+		a = hostRandomIndexFM(pool, HOST_POPULATION_SIZE);
+		b = hostRandomIndexFM(pool, HOST_POPULATION_SIZE);
+		iWinnerY = (evaluation[a] < evaluation[b]) ? a : b;
+
+		/* The first offspring takes MASK from X and the second one from Y (an odd population drops the last one). */
+		memcpy(x[i], population[iWinnerX], sizeof(x[i]));
+		memcpy(y[i], population[iWinnerY], sizeof(y[i]));
+		if(first + i + 1 < last)
+		{
+			memcpy(x[i + 1], population[iWinnerY], sizeof(x[i + 1]));
+			memcpy(y[i + 1], population[iWinnerX], sizeof(y[i + 1]));
+		}
+	}
+	hostCrossoverFM(newPopulation[first], x[0], y[0], (size_t) (last - first) * DIMENSION);
+
+	/* Applies the mutation over the individuals of this block that are mutated. */
+	if(first == 0)
+	{
+		first = 1;
+	}
+	if(last > HOST_MUTATED_INDIVIDUALS + 1)
+	{
+		last = HOST_MUTATED_INDIVIDUALS + 1;
+	}
+	for(i = first; i < last; i++)
+	{
+		for(j = 0; j < DIMENSION; j++)
+		{
+#if CHROMOSOME_SIZE & (CHROMOSOME_SIZE - 1)
+			y[i - first][j] = (chromosome_t) 1 << hostRandomIndexFM(pool, CHROMOSOME_SIZE);
+#else
+			y[i - first][j] = (chromosome_t) 1 << (hostPoolRandFM(pool) & (CHROMOSOME_SIZE - 1));
+#endif
+		}
+	}
+	if(first < last)
+	{
+		hostMutationFM(newPopulation[first], y[0], (size_t) (last - first) * DIMENSION);
+	}
+}
+
+/**
+ * This function finds the best individual between the ones found by each thread.
+ *
+ * @param evaluation A vector that stores the fitness values.
+ * @param best The best individual of each thread.
+ * @return The index of the best individual (the first one if there is a tie).
+ */
+static hostsize_t hostBestFM(fitness_t evaluation[], hostsize_t best[])
+{
+	uint32_t t;
+	hostsize_t iBest;
+
+	iBest = best[0];
+	for(t = 1; t < HOST_THREADS; t++)
+	{
+		if(best[t] < HOST_POPULATION_SIZE && (evaluation[best[t]] < evaluation[iBest] || (evaluation[best[t]] == evaluation[iBest] && best[t] < iBest)))
+		{
+			iBest = best[t];
+		}
+	}
+
+	return iBest;
+}
+
+/**
+ * This function is run by every thread. The threads meet at a barrier after each phase and
+ * keep their own copy of the population pointers, which they swap at the same time.
+ *
+ * @param arg The host_worker of the thread.
+ * @return Nothing.
+ */
+static void *hostWorkerFM(void *arg)
+{
+	host_worker *worker = (host_worker *) arg;
+	host_shared *shared = worker->shared;
+	chromosome_t (*population)[DIMENSION] = shared->population;
+	chromosome_t (*newPopulation)[DIMENSION] = shared->newPopulation;
+	chromosome_t (*swap)[DIMENSION];
+	hostpool_t *pool;
+	chromosome_t (*x)[DIMENSION], (*y)[DIMENSION];
+	hostsize_t block, i, last, iBest;
+	uint32_t k;
+	dimensionsize_t j;
+
+	x = malloc(HOST_BLOCK * sizeof(x[0]));
+	y = malloc(HOST_BLOCK * sizeof(y[0]));
+	pool = malloc(sizeof(hostpool_t));
+	if(x == 0 || y == 0 || pool == 0)
+	{
+		abort();
+	}
+
+	/* Initializes the population. */
+	for(block = worker->id; block < HOST_BLOCKS; block += HOST_THREADS)
+	{
+		hostSeedFM(pool, 0, PHASE_INITIALIZATION, block);
+		last = (block == HOST_BLOCKS - 1) ? HOST_POPULATION_SIZE : (block + 1) * HOST_BLOCK;
+		for(i = block * HOST_BLOCK; i < last; i++)
+		{
+			for(j = 0; j < DIMENSION; j++)
+			{
+				population[i][j] = (chromosome_t) (hostPoolRandFM(pool) & GENE_MAX);
+			}
+		}
+	}
+
+	/* Calculates the fitness for all individuals. */
+	shared->best[worker->id] = hostFitnessFM(shared->evaluation, population, worker->id);
+	pthread_barrier_wait(&shared->barrier);
+
+	for(k = 0; k < HOST_NUM_GENERATIONS; k++)
+	{
+		iBest = hostBestFM(shared->evaluation, shared->best);
+
+		/* Generates a new population, keeping the best individual in the first position. */
+		for(block = worker->id; block < HOST_BLOCKS; block += HOST_THREADS)
+		{
+			hostNewBlockFM(shared->evaluation, population, newPopulation, x, y, pool, k, block);
+			if(block == 0)
+			{
+				memcpy(newPopulation[0], population[iBest], sizeof(newPopulation[0]));
+			}
+		}
+		pthread_barrier_wait(&shared->barrier);
+
+		swap = population;
+		population = newPopulation;
+		newPopulation = swap;
+
+		/* Calculates the fitness again. */
+		shared->best[worker->id] = hostFitnessFM(shared->evaluation, population, worker->id);
+		pthread_barrier_wait(&shared->barrier);
+	}
+
+	/* The last population may be in the second buffer. */
+	if(worker->id == 0 && population != shared->population)
+	{
+		memcpy(shared->population, population, (size_t) HOST_POPULATION_SIZE * sizeof(population[0]));
+	}
+
+	free(x);
+	free(y);
+	free(pool);
+
+	return 0;
+}
+
+/**
+ * This function runs the genetic algorithm on the host, splitting every phase of each
+ * generation between HOST_THREADS threads.
+ *
+ * @param evaluation A vector that will store the fitness values (HOST_POPULATION_SIZE values).
+ * @param population A vector containing the individuals (HOST_POPULATION_SIZE individuals).
+ * @return The index of the best individual in the population after the last generation.
+ */
+hostsize_t hostGeneticAlgorithmFM(fitness_t evaluation[], chromosome_t population[][DIMENSION])
+{
+	host_shared shared;
+	host_worker workers[HOST_THREADS];
+	pthread_t threads[HOST_THREADS];
+	uint32_t t;
+
+	shared.evaluation = evaluation;
+	shared.population = population;
+	shared.newPopulation = malloc((size_t) HOST_POPULATION_SIZE * sizeof(population[0]));
+	if(shared.newPopulation == 0)
+	{
+		abort();
+	}
+	pthread_barrier_init(&shared.barrier, 0, HOST_THREADS);
+
+	for(t = 0; t < HOST_THREADS; t++)
+	{
+		workers[t].shared = &shared;
+		workers[t].id = t;
+
+		/* The calling thread is the thread 0. */
+		if(t > 0 && pthread_create(&threads[t], 0, hostWorkerFM, &workers[t]) != 0)
+		{
+			abort();
+		}
+	}
+	hostWorkerFM(&workers[0]);
+
+	for(t = 1; t < HOST_THREADS; t++)
+	{
+		pthread_join(threads[t], 0);
+	}
+
+	pthread_barrier_destroy(&shared.barrier);
+	free(shared.newPopulation);
+
+	return hostBestFM(evaluation, shared.best);
+}
+
+/**
+ * This function seeds the random pool of a block, so the result does not depend on the
+ * number of threads nor on which thread runs the block.
+ *
+ * @param pool The pool.
+ * @param generation The generation.
+ * @param phase The phase that uses the pool (PHASE_INITIALIZATION or PHASE_SELECTION).
+ * @param block The index of the block.
+ */
+void hostSeedFM(hostpool_t *pool, uint32_t generation, uint32_t phase, hostsize_t block)
+{
+	hostrng_t rng;
+	uint32_t w, l;
+
+	/* Each (generation, phase, block) gets a different value, which is then mixed so nearby blocks
+	get unrelated streams. */
+	rng = ((uint64_t) HOST_SEED << 32) ^ ((uint64_t) generation << 34) ^ ((uint64_t) phase << 32) ^ block;
+	rng = (uint64_t) hostRandFM(&rng) << 32 | hostRandFM(&rng);
+
+	/* A lane whose four words are zero would only give zeros. */
+	for(l = 0; l < HOST_LANES; l++)
+	{
+		do
+		{
+			for(w = 0; w < 4; w++)
+			{
+				pool->state[w][l] = hostRandFM(&rng);
+			}
+		}
+		while((pool->state[0][l] | pool->state[1][l] | pool->state[2][l] | pool->state[3][l]) == 0);
+	}
+	pool->next = HOST_POOL;
+}
+
+/**
+ * This function draws 32 random bits (SplitMix64 output function), it is used to seed the pools.
+ *
+ * @param rng The stream.
+ * @return The random number.
+ */
+uint32_t hostRandFM(hostrng_t *rng)
+{
+	uint64_t z = (*rng += UINT64_C(0x9E3779B97F4A7C15));
+
+	z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+	z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+	return (uint32_t) ((z ^ (z >> 31)) >> 32);
+}
+
+/**
+ * This function takes the next random number of a pool, generating HOST_POOL new ones when
+ * all of them were used.
+ *
+ * @param pool The pool.
+ * @return The random number.
+ */
+uint32_t hostPoolRandFM(hostpool_t *pool)
+{
+	if(pool->next == HOST_POOL)
+	{
+		hostRandomFM(pool->state, pool->values, HOST_POOL);
+		pool->next = 0;
+	}
+
+	return pool->values[pool->next++];
+}
+
+/**
+ * This function draws a random index between 0 and n - 1 without bias for any n, by multiplying
+ * a 32-bit number by n and rejecting the few products that would favour some indexes.
+ *
+ * @param pool The pool.
+ * @param n The number of indexes.
+ * @return The random index.
+ */
+hostsize_t hostRandomIndexFM(hostpool_t *pool, hostsize_t n)
+{
+	uint64_t m;
+	uint32_t threshold;
+
+	m = (uint64_t) hostPoolRandFM(pool) * n;
+	if((uint32_t) m < n)
+	{
+		/* 2^32 mod n, the products whose low half is below it are rejected. */
+		threshold = -n % n;
+		while((uint32_t) m < threshold)
+		{
+			m = (uint64_t) hostPoolRandFM(pool) * n;
+		}
+	}
+
+	return (hostsize_t) (m >> 32);
+}
@@ -0,0 +1,110 @@
+/* Host build of the genetic algorithm, used to prototype objectives with populations the
+microcontrollers cannot store. It shares the chromosome configuration and evaluationFM with ga.h. */
+
+#ifndef HOST_H_
+#define HOST_H_
+
+#include "../ga.h"
+
+#include <stdint.h>
+
+/* Configuration of the host build */
+
+#define HOST_POPULATION_SIZE 1000000 /* Between 2 and 2^32 - 1, it does not need to be a power of two. */
+#define HOST_NUM_GENERATIONS 100
+#define HOST_MUTATED_INDIVIDUALS (HOST_POPULATION_SIZE / 16) /* Between 0 and HOST_POPULATION_SIZE - 1. */
+#define HOST_THREADS 4 /* Threads that run selection, crossover, mutation and fitness. */
+#define HOST_BLOCK 4096 /* Individuals handled at once by a thread, each block has its own random stream. */
+#define HOST_SEED 96233
+#define HOST_SIMD 1 /* Use SSE2/AVX2 crossover, mutation and random numbers when the CPU has them, 0 forces the scalar kernels. */
+#define HOST_POOL 1024 /* Random numbers generated at once for a block, a multiple of HOST_LANES. */
+
+/*  DO NOT EDIT ANYTHING BELLOW THIS POINT */
+
+#if HOST_POPULATION_SIZE < 2 || HOST_POPULATION_SIZE > 4294967295
+	#error "HOST_POPULATION_SIZE must be between 2 and 2^32 - 1"
+#endif
+
+#if HOST_MUTATED_INDIVIDUALS >= HOST_POPULATION_SIZE
+	#error "HOST_MUTATED_INDIVIDUALS must be below HOST_POPULATION_SIZE"
+#endif
+
+#if HOST_THREADS < 1
+	#error "HOST_THREADS must be at least 1"
+#endif
+
+#if HOST_BLOCK < 2 || HOST_BLOCK % 2
+	#error "HOST_BLOCK must be even"
+#endif
+
+/* Interleaved generators of each random pool (one AVX2 vector of 32-bit lanes). */
+#define HOST_LANES 8
+
+#if HOST_POOL < HOST_LANES || HOST_POOL % HOST_LANES
+	#error "HOST_POOL must be a multiple of HOST_LANES"
+#endif
+
+typedef uint32_t hostsize_t;
+
+/* State of the stream that seeds the random pool of a block. */
+typedef uint64_t hostrng_t;
+
+/* Random numbers of a block, generated HOST_POOL at a time by HOST_LANES xoshiro128** generators
+whose outputs are interleaved (the k-th number comes from the lane k % HOST_LANES). */
+typedef struct {
+	uint32_t state[4][HOST_LANES]; /* Word w of the lane l is state[w][l]. */
+	uint32_t values[HOST_POOL];
+	uint32_t next; /* Next value to use, HOST_POOL when the pool must be generated again. */
+} hostpool_t;
+
+/* Functions definitions */
+
+/**
+ * This function runs the genetic algorithm on the host, splitting every phase of each
+ * generation between HOST_THREADS threads.
+ *
+ * @param evaluation A vector that will store the fitness values (HOST_POPULATION_SIZE values).
+ * @param population A vector containing the individuals (HOST_POPULATION_SIZE individuals).
+ * @return The index of the best individual in the population after the last generation.
+ */
+hostsize_t hostGeneticAlgorithmFM(fitness_t evaluation[], chromosome_t population[][DIMENSION]);
+
+/**
+ * This function seeds the random pool of a block, so the result does not depend on the
+ * number of threads nor on which thread runs the block.
+ *
+ * @param pool The pool.
+ * @param generation The generation.
+ * @param phase The phase that uses the pool (initialization or new population).
+ * @param block The index of the block.
+ */
+void hostSeedFM(hostpool_t *pool, uint32_t generation, uint32_t phase, hostsize_t block);
+
+/**
+ * This function draws 32 random bits (SplitMix64 output function), it is used to seed the pools.
+ *
+ * @param rng The stream.
+ * @return The random number.
+ */
+uint32_t hostRandFM(hostrng_t *rng);
+
+/**
+ * This function takes the next random number of a pool, generating HOST_POOL new ones when
+ * all of them were used.
+ *
+ * @param pool The pool.
+ * @return The random number.
+ */
+uint32_t hostPoolRandFM(hostpool_t *pool);
+
+/**
+ * This function draws a random index between 0 and n - 1 without bias for any n, by multiplying
+ * a 32-bit number by n and rejecting the few products that would favour some indexes.
+ *
+ * @param pool The pool.
+ * @param n The number of indexes.
+ * @return The random index.
+ */
+hostsize_t hostRandomIndexFM(hostpool_t *pool, hostsize_t n);
+
+#endif /* HOST_H_ */
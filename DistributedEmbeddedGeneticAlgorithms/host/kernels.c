@@ -0,0 +1,254 @@
+#include "kernels.h"
+
+#if HOST_SIMD && (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+	#define HOST_X86 1
+	#include <immintrin.h>
+#else
+	#define HOST_X86 0
+#endif
+
+static void crossoverScalarFM(chromosome_t out[], const chromosome_t x[], const chromosome_t y[], size_t n);
+static void mutationScalarFM(chromosome_t genes[], const chromosome_t masks[], size_t n);
+static void randomScalarFM(uint32_t state[4][HOST_LANES], uint32_t out[], size_t n);
+
+void (*hostCrossoverFM)(chromosome_t out[], const chromosome_t x[], const chromosome_t y[], size_t n) = crossoverScalarFM;
+void (*hostMutationFM)(chromosome_t genes[], const chromosome_t masks[], size_t n) = mutationScalarFM;
+void (*hostRandomFM)(uint32_t state[4][HOST_LANES], uint32_t out[], size_t n) = randomScalarFM;
+
+static void crossoverScalarFM(chromosome_t out[], const chromosome_t x[], const chromosome_t y[], size_t n)
+{
+	size_t k;
+
+	for(k = 0; k < n; k++)
+	{
+		out[k] = (x[k] & MASK) | (y[k] & ~MASK);
+	}
+}
+
+static void mutationScalarFM(chromosome_t genes[], const chromosome_t masks[], size_t n)
+{
+	size_t k;
+
+	for(k = 0; k < n; k++)
+	{
+		genes[k] ^= masks[k];
+	}
+}
+
+/* One step of xoshiro128** in every lane. The products by 5 and 9 are shifts and additions, so the
+SSE2 versions do not need a 32-bit vector product either. */
+static void randomScalarFM(uint32_t state[4][HOST_LANES], uint32_t out[], size_t n)
+{
+	uint32_t s0, s1, s2, s3, r, t;
+	size_t k, l;
+
+	for(l = 0; l < HOST_LANES; l++)
+	{
+		s0 = state[0][l];
+		s1 = state[1][l];
+		s2 = state[2][l];
+		s3 = state[3][l];
+		for(k = l; k < n; k += HOST_LANES)
+		{
+			r = s1 + (s1 << 2);
+			r = (r << 7) | (r >> 25);
+			out[k] = r + (r << 3);
+			t = s1 << 9;
+			s2 ^= s0;
+			s3 ^= s1;
+			s1 ^= s2;
+			s0 ^= s3;
+			s2 ^= t;
+			s3 = (s3 << 11) | (s3 >> 21);
+		}
+		state[0][l] = s0;
+		state[1][l] = s1;
+		state[2][l] = s2;
+		state[3][l] = s3;
+	}
+}
+
+#if HOST_X86
+
+/* The vectors hold 16 / sizeof(chromosome_t) genes with MASK in each lane, the genes that do
+not fill a vector are done by the scalar loop. */
+
+__attribute__((target("sse2")))
+static void crossoverSse2FM(chromosome_t out[], const chromosome_t x[], const chromosome_t y[], size_t n)
+{
+	const size_t lanes = sizeof(__m128i) / sizeof(chromosome_t);
+	chromosome_t mask[sizeof(__m128i) / sizeof(chromosome_t)];
+	__m128i m, vx, vy;
+	size_t k;
+
+	for(k = 0; k < lanes; k++)
+	{
+		mask[k] = MASK;
+	}
+	m = _mm_loadu_si128((const __m128i *) mask);
+
+	for(k = 0; k + lanes <= n; k += lanes)
+	{
+		vx = _mm_loadu_si128((const __m128i *) &x[k]);
+		vy = _mm_loadu_si128((const __m128i *) &y[k]);
+		_mm_storeu_si128((__m128i *) &out[k], _mm_or_si128(_mm_and_si128(vx, m), _mm_andnot_si128(m, vy)));
+	}
+	crossoverScalarFM(&out[k], &x[k], &y[k], n - k);
+}
+
+__attribute__((target("sse2")))
+static void mutationSse2FM(chromosome_t genes[], const chromosome_t masks[], size_t n)
+{
+	const size_t lanes = sizeof(__m128i) / sizeof(chromosome_t);
+	__m128i v;
+	size_t k;
+
+	for(k = 0; k + lanes <= n; k += lanes)
+	{
+		v = _mm_xor_si128(_mm_loadu_si128((const __m128i *) &genes[k]), _mm_loadu_si128((const __m128i *) &masks[k]));
+		_mm_storeu_si128((__m128i *) &genes[k], v);
+	}
+	mutationScalarFM(&genes[k], &masks[k], n - k);
+}
+
+__attribute__((target("avx2")))
+static void crossoverAvx2FM(chromosome_t out[], const chromosome_t x[], const chromosome_t y[], size_t n)
+{
+	const size_t lanes = sizeof(__m256i) / sizeof(chromosome_t);
+	chromosome_t mask[sizeof(__m256i) / sizeof(chromosome_t)];
+	__m256i m, vx, vy;
+	size_t k;
+
+	for(k = 0; k < lanes; k++)
+	{
+		mask[k] = MASK;
+	}
+	m = _mm256_loadu_si256((const __m256i *) mask);
+
+	for(k = 0; k + lanes <= n; k += lanes)
+	{
+		vx = _mm256_loadu_si256((const __m256i *) &x[k]);
+		vy = _mm256_loadu_si256((const __m256i *) &y[k]);
+		_mm256_storeu_si256((__m256i *) &out[k], _mm256_or_si256(_mm256_and_si256(vx, m), _mm256_andnot_si256(m, vy)));
+	}
+	crossoverScalarFM(&out[k], &x[k], &y[k], n - k);
+}
+
+__attribute__((target("avx2")))
+static void mutationAvx2FM(chromosome_t genes[], const chromosome_t masks[], size_t n)
+{
+	const size_t lanes = sizeof(__m256i) / sizeof(chromosome_t);
+	__m256i v;
+	size_t k;
+
+	for(k = 0; k + lanes <= n; k += lanes)
+	{
+		v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) &genes[k]), _mm256_loadu_si256((const __m256i *) &masks[k]));
+		_mm256_storeu_si256((__m256i *) &genes[k], v);
+	}
+	mutationScalarFM(&genes[k], &masks[k], n - k);
+}
+
+/* The 8 lanes are two vectors, which are independent and interleave in the pipeline. */
+__attribute__((target("sse2")))
+static void randomSse2FM(uint32_t state[4][HOST_LANES], uint32_t out[], size_t n)
+{
+	__m128i s0[2], s1[2], s2[2], s3[2], r, t;
+	size_t k, v;
+
+	for(v = 0; v < 2; v++)
+	{
+		s0[v] = _mm_loadu_si128((const __m128i *) &state[0][4 * v]);
+		s1[v] = _mm_loadu_si128((const __m128i *) &state[1][4 * v]);
+		s2[v] = _mm_loadu_si128((const __m128i *) &state[2][4 * v]);
+		s3[v] = _mm_loadu_si128((const __m128i *) &state[3][4 * v]);
+	}
+
+	for(k = 0; k < n; k += HOST_LANES)
+	{
+		for(v = 0; v < 2; v++)
+		{
+			r = _mm_add_epi32(s1[v], _mm_slli_epi32(s1[v], 2));
+			r = _mm_or_si128(_mm_slli_epi32(r, 7), _mm_srli_epi32(r, 25));
+			_mm_storeu_si128((__m128i *) &out[k + 4 * v], _mm_add_epi32(r, _mm_slli_epi32(r, 3)));
+			t = _mm_slli_epi32(s1[v], 9);
+			s2[v] = _mm_xor_si128(s2[v], s0[v]);
+			s3[v] = _mm_xor_si128(s3[v], s1[v]);
+			s1[v] = _mm_xor_si128(s1[v], s2[v]);
+			s0[v] = _mm_xor_si128(s0[v], s3[v]);
+			s2[v] = _mm_xor_si128(s2[v], t);
+			s3[v] = _mm_or_si128(_mm_slli_epi32(s3[v], 11), _mm_srli_epi32(s3[v], 21));
+		}
+	}
+
+	for(v = 0; v < 2; v++)
+	{
+		_mm_storeu_si128((__m128i *) &state[0][4 * v], s0[v]);
+		_mm_storeu_si128((__m128i *) &state[1][4 * v], s1[v]);
+		_mm_storeu_si128((__m128i *) &state[2][4 * v], s2[v]);
+		_mm_storeu_si128((__m128i *) &state[3][4 * v], s3[v]);
+	}
+}
+
+__attribute__((target("avx2")))
+static void randomAvx2FM(uint32_t state[4][HOST_LANES], uint32_t out[], size_t n)
+{
+	__m256i s0, s1, s2, s3, r, t;
+	size_t k;
+
+	s0 = _mm256_loadu_si256((const __m256i *) state[0]);
+	s1 = _mm256_loadu_si256((const __m256i *) state[1]);
+	s2 = _mm256_loadu_si256((const __m256i *) state[2]);
+	s3 = _mm256_loadu_si256((const __m256i *) state[3]);
+
+	for(k = 0; k < n; k += HOST_LANES)
+	{
+		r = _mm256_add_epi32(s1, _mm256_slli_epi32(s1, 2));
+		r = _mm256_or_si256(_mm256_slli_epi32(r, 7), _mm256_srli_epi32(r, 25));
+		_mm256_storeu_si256((__m256i *) &out[k], _mm256_add_epi32(r, _mm256_slli_epi32(r, 3)));
+		t = _mm256_slli_epi32(s1, 9);
+		s2 = _mm256_xor_si256(s2, s0);
+		s3 = _mm256_xor_si256(s3, s1);
+		s1 = _mm256_xor_si256(s1, s2);
+		s0 = _mm256_xor_si256(s0, s3);
+		s2 = _mm256_xor_si256(s2, t);
+		s3 = _mm256_or_si256(_mm256_slli_epi32(s3, 11), _mm256_srli_epi32(s3, 21));
+	}
+
+	_mm256_storeu_si256((__m256i *) state[0], s0);
+	_mm256_storeu_si256((__m256i *) state[1], s1);
+	_mm256_storeu_si256((__m256i *) state[2], s2);
+	_mm256_storeu_si256((__m256i *) state[3], s3);
+}
+
+#endif /* HOST_X86 */
+
+/**
+ * This function picks the kernels for this CPU. It is called once, before any thread starts.
+ *
+ * @return The name of the kernels ("scalar", "sse2" or "avx2").
+ */
+const char *hostKernelsFM(void)
+{
+#if HOST_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+	{
+		hostCrossoverFM = crossoverAvx2FM;
+		hostMutationFM = mutationAvx2FM;
+		hostRandomFM = randomAvx2FM;
+		return "avx2";
+	}
+	if(__builtin_cpu_supports("sse2"))
+	{
+		hostCrossoverFM = crossoverSse2FM;
+		hostMutationFM = mutationSse2FM;
+		hostRandomFM = randomSse2FM;
+		return "sse2";
+	}
+#endif
+	hostCrossoverFM = crossoverScalarFM;
+	hostMutationFM = mutationScalarFM;
+	hostRandomFM = randomScalarFM;
+	return "scalar";
+}
@@ -0,0 +1,48 @@
+/* Bit-parallel crossover, mutation and random number kernels of the host build. The scalar, SSE2
+and AVX2 versions give the same bits, the fastest one supported by the CPU is picked at run time. */
+
+#ifndef KERNELS_H_
+#define KERNELS_H_
+
+#include "host.h"
+
+#include <stddef.h>
+
+/**
+ * This function crosses genes: out[k] = (x[k] & MASK) | (y[k] & ~MASK). Storing the pairs of
+ * winners as x = {X, Y} and y = {Y, X} gives both offspring of each pair in a single pass.
+ *
+ * @param out A vector that will store the new genes.
+ * @param x A vector with the genes that give the bits of MASK.
+ * @param y A vector with the genes that give the other bits.
+ * @param n The number of genes.
+ */
+extern void (*hostCrossoverFM)(chromosome_t out[], const chromosome_t x[], const chromosome_t y[], size_t n);
+
+/**
+ * This function mutates genes: genes[k] ^= masks[k].
+ *
+ * @param genes A vector with the genes.
+ * @param masks A vector with the bits to flip in each gene.
+ * @param n The number of genes.
+ */
+extern void (*hostMutationFM)(chromosome_t genes[], const chromosome_t masks[], size_t n);
+
+/**
+ * This function generates random numbers with the HOST_LANES xoshiro128** generators of a pool:
+ * out[k] is the next number of the lane k % HOST_LANES.
+ *
+ * @param state The state of the generators (word w of the lane l in state[w][l]).
+ * @param out A vector that will store the random numbers.
+ * @param n The number of random numbers, a multiple of HOST_LANES.
+ */
+extern void (*hostRandomFM)(uint32_t state[4][HOST_LANES], uint32_t out[], size_t n);
+
+/**
+ * This function picks the kernels for this CPU. It is called once, before any thread starts.
+ *
+ * @return The name of the kernels ("scalar", "sse2" or "avx2").
+ */
+const char *hostKernelsFM(void);
+
+#endif /* KERNELS_H_ */
@@ -0,0 +1,56 @@
+#include "host.h"
+#include "kernels.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef PI
+#define PI 3.14159265358979323846
+#endif
+
+/* Same signature as the evaluationFM of the microcontrollers, so the objective can be moved to main.c as is. */
+fitness_t evaluationFM(normalization_t xn[])
+{
+	return 21.5 + xn[0]*(sin(40*PI*xn[0]) + cos(20*PI*xn[0])); // f4
+}
+
+int main(void)
+{
+	fitness_t *evaluation;
+	chromosome_t (*population)[DIMENSION];
+	normalization_t normalizedChromosome[DIMENSION];
+	hostsize_t iBest;
+	dimensionsize_t j;
+	struct timespec start, end;
+	const char *kernels;
+
+	evaluation = malloc((size_t) HOST_POPULATION_SIZE * sizeof(fitness_t));
+	population = malloc((size_t) HOST_POPULATION_SIZE * sizeof(population[0]));
+	if(evaluation == 0 || population == 0)
+	{
+		fprintf(stderr, "not enough memory for %lu individuals\n", (unsigned long) HOST_POPULATION_SIZE);
+		return 1;
+	}
+
+	kernels = hostKernelsFM();
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	iBest = hostGeneticAlgorithmFM(evaluation, population);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for(j = 0; j < DIMENSION; j++)
+	{
+		normalizedChromosome[j] = NORMALIZATION_MIN + ((normalization_t) NORMALIZED_GAIN) * population[iBest][j];
+	}
+
+	printf("[host] index = %lu, value = %f, fitness = %f\n", (unsigned long) iBest, normalizedChromosome[0], evaluation[iBest]);
+	printf("[host] %lu individuals, %d generations, %d threads, %s kernels, %.3f s\n", (unsigned long) HOST_POPULATION_SIZE,
+		HOST_NUM_GENERATIONS, HOST_THREADS, kernels, (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+
+	free(population);
+	free(evaluation);
+
+	return 0;
+}
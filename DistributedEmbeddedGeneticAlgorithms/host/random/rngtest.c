@@ -0,0 +1,419 @@
+/* Speed and quality of the generators of random/, measured on the host. Every test runs on the
+whole output of each generator and on the low bits the GA masks to draw indexes, then the
+generators are ranked by the tests they pass and by their speed. */
+
+#include "../../ga.h"
+#include "../../random/lcg.h"
+#include "../../random/lfsr.h"
+#include "../../random/mt.h"
+#include "../../random/mwc.h"
+#include "../../random/sm.h"
+#include "../../random/xoshiro.h"
+#include "../../random/xs.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RNG_SEED 96233
+#define RNG_SPEED_DRAWS (1UL << 26) /* Draws timed for each generator. */
+#define RNG_SYMBOLS (1UL << 22) /* Symbols used by each test. */
+#define RNG_GAP_MAX 16 /* Gaps of this length or longer are counted together. */
+#define RNG_BIRTHDAYS 1024 /* Birthdays in a year of 2^24 days (16 repeated spacings expected per year). */
+#define RNG_BIRTHDAY_YEARS 256
+#define RNG_ALPHA 0.001 /* A test fails when its two-sided p-value is below this. */
+
+#define RNG_TESTS 5
+#define RNG_VIEWS 3
+
+typedef struct {
+	const char *name;
+	uint8_t bits; /* Bits of each draw. */
+	void (*srand)(uint32_t seed);
+	uint32_t (*rand)(void);
+} rng_generator;
+
+/* The symbols a test reads from a generator: either the low `width` bits of each draw (as the GA
+masks its indexes) or all the bits of the draws, `width` at a time. */
+typedef struct {
+	const char *name;
+	uint8_t width;
+	uint8_t low;
+} rng_view;
+
+typedef struct {
+	const rng_generator *generator;
+	const rng_view *view;
+	uint32_t buffer;
+	uint8_t left;
+} rng_source;
+
+typedef struct {
+	const rng_generator *generator;
+	double p[RNG_VIEWS][RNG_TESTS];
+	int passed;
+	double draws; /* Per second. */
+} rng_result;
+
+static const char *testNames[RNG_TESTS] = {"frequency", "serial", "gap", "runs", "birthday"};
+
+static void lfsr8Srand(uint32_t seed) { lfsr_srand8((uint8_t) seed); }
+static void lfsr16Srand(uint32_t seed) { lfsr_srand16((uint16_t) seed); }
+static uint32_t lfsr8Rand(void) { return lfsr_rand8(); }
+static uint32_t lfsr16Rand(void) { return lfsr_rand16(); }
+static uint32_t xoshiro8Rand(void) { return xoshiro_rand8(); }
+static uint32_t xoshiro16Rand(void) { return xoshiro_rand16(); }
+
+static const rng_generator generators[] = {
+	{"lcg", 31, lcg_srand, lcg_rand},
+	{"lfsr8", 8, lfsr8Srand, lfsr8Rand},
+	{"lfsr16", 16, lfsr16Srand, lfsr16Rand},
+	{"lfsr32", 32, lfsr_srand32, lfsr_rand32},
+	{"mt", 32, mt_srand, mt_rand},
+	{"mwc", 32, mwc_srand, mwc_rand},
+	{"sm", 32, sm_srand, sm_rand},
+	{"xoshiro8", 8, xoshiro_srand, xoshiro8Rand},
+	{"xoshiro16", 16, xoshiro_srand, xoshiro16Rand},
+	{"xoshiro32", 32, xoshiro_srand, xoshiro_rand32},
+	{"xs", 32, xs_srand, xs_rand},
+};
+
+#define RNG_GENERATORS (sizeof(generators) / sizeof(generators[0]))
+
+static uint32_t nextSymbol(rng_source *source)
+{
+	uint32_t mask = (1UL << source->view->width) - 1;
+
+	if(source->view->low)
+	{
+		return source->generator->rand() & mask;
+	}
+
+	if(source->left < source->view->width)
+	{
+		source->buffer = source->generator->rand();
+		source->left = source->generator->bits;
+	}
+	source->left -= source->view->width;
+	return (source->buffer >> source->left) & mask;
+}
+
+/* Gives the bits of the symbols one at a time, most significant first. */
+static uint32_t nextBits(rng_source *source, uint8_t count, uint32_t *symbol, uint8_t *left)
+{
+	uint32_t value = 0;
+
+	while(count--)
+	{
+		if(*left == 0)
+		{
+			*symbol = nextSymbol(source);
+			*left = source->view->width;
+		}
+		(*left)--;
+		value = (value << 1) | ((*symbol >> *left) & 1);
+	}
+	return value;
+}
+
+/* Regularized upper incomplete gamma Q(a, x), by its series below a + 1 and by its continued
+fraction above. */
+static double gammaQ(double a, double x)
+{
+	double sum, term, b, c, d, h, an;
+	int n;
+
+	if(x <= 0)
+	{
+		return 1;
+	}
+	if(x < a + 1)
+	{
+		term = sum = 1 / a;
+		for(n = 1; n < 1000 && fabs(term) > fabs(sum) * 1e-15; n++)
+		{
+			term *= x / (a + n);
+			sum += term;
+		}
+		return 1 - sum * exp(-x + a * log(x) - lgamma(a));
+	}
+
+	b = x + 1 - a;
+	c = 1e300;
+	d = 1 / b;
+	h = d;
+	for(n = 1; n < 1000; n++)
+	{
+		an = -n * (n - a);
+		b += 2;
+		d = an * d + b;
+		d = (fabs(d) < 1e-300) ? 1e-300 : d;
+		c = b + an / c;
+		c = (fabs(c) < 1e-300) ? 1e-300 : c;
+		d = 1 / d;
+		h *= d * c;
+		if(fabs(d * c - 1) < 1e-15)
+		{
+			break;
+		}
+	}
+	return exp(-x + a * log(x) - lgamma(a)) * h;
+}
+
+/* Two-sided p-value of a chi-square statistic, so a fit too good to be random also fails. */
+static double chiSquareP(double chi, double freedom)
+{
+	double p = gammaQ(freedom / 2, chi / 2);
+
+	return 2 * (p < 0.5 ? p : 1 - p);
+}
+
+static double chiSquare(const uint64_t observed[], const double expected[], uint32_t cells)
+{
+	double chi = 0, d;
+	uint32_t k;
+
+	for(k = 0; k < cells; k++)
+	{
+		d = observed[k] - expected[k];
+		chi += d * d / expected[k];
+	}
+	return chi;
+}
+
+/* Counts of each symbol. */
+static double frequencyTest(rng_source *source)
+{
+	uint32_t cells = 1UL << source->view->width, k;
+	uint64_t *observed = calloc(cells, sizeof(uint64_t));
+	double *expected = malloc(cells * sizeof(double));
+	double chi;
+	uint64_t n;
+
+	for(n = 0; n < RNG_SYMBOLS; n++)
+	{
+		observed[nextSymbol(source)]++;
+	}
+	for(k = 0; k < cells; k++)
+	{
+		expected[k] = (double) RNG_SYMBOLS / cells;
+	}
+	chi = chiSquare(observed, expected, cells);
+
+	free(observed);
+	free(expected);
+	return chiSquareP(chi, cells - 1);
+}
+
+/* Counts of each pair of consecutive symbols (e.g. the two contenders of a tournament). */
+static double serialTest(rng_source *source)
+{
+	uint32_t cells = 1UL << (2 * source->view->width), k, a;
+	uint64_t *observed = calloc(cells, sizeof(uint64_t));
+	double *expected = malloc(cells * sizeof(double));
+	double chi;
+	uint64_t n;
+
+	for(n = 0; n < RNG_SYMBOLS / 2; n++)
+	{
+		a = nextSymbol(source);
+		observed[(a << source->view->width) | nextSymbol(source)]++;
+	}
+	for(k = 0; k < cells; k++)
+	{
+		expected[k] = (double) (RNG_SYMBOLS / 2) / cells;
+	}
+	chi = chiSquare(observed, expected, cells);
+
+	free(observed);
+	free(expected);
+	return chiSquareP(chi, cells - 1);
+}
+
+/* Lengths of the gaps between symbols of the lower half, geometric with p = 1/2. */
+static double gapTest(rng_source *source)
+{
+	uint64_t observed[RNG_GAP_MAX + 1] = {0};
+	double expected[RNG_GAP_MAX + 1];
+	uint64_t n, gaps = 0;
+	uint32_t half = 1UL << (source->view->width - 1), length = 0, k;
+
+	for(n = 0; n < RNG_SYMBOLS; n++)
+	{
+		if(nextSymbol(source) < half)
+		{
+			observed[length < RNG_GAP_MAX ? length : RNG_GAP_MAX]++;
+			gaps++;
+			length = 0;
+		}
+		else
+		{
+			length++;
+		}
+	}
+	for(k = 0; k < RNG_GAP_MAX; k++)
+	{
+		expected[k] = gaps * ldexp(1, -(int) (k + 1));
+	}
+	expected[RNG_GAP_MAX] = gaps * ldexp(1, -RNG_GAP_MAX);
+
+	return chiSquareP(chiSquare(observed, expected, RNG_GAP_MAX + 1), RNG_GAP_MAX);
+}
+
+/* Number of runs of equal bits (NIST SP 800-22), for a bit stream that passes the monobit test. */
+static double runsTest(rng_source *source)
+{
+	uint64_t n = (uint64_t) RNG_SYMBOLS * source->view->width, k, ones = 0, runs = 1;
+	uint32_t symbol = 0, bit, previous;
+	uint8_t left = 0;
+	double pi;
+
+	previous = nextBits(source, 1, &symbol, &left);
+	ones += previous;
+	for(k = 1; k < n; k++)
+	{
+		bit = nextBits(source, 1, &symbol, &left);
+		ones += bit;
+		runs += (bit != previous);
+		previous = bit;
+	}
+
+	pi = (double) ones / n;
+	if(fabs(pi - 0.5) >= 2 / sqrt((double) n))
+	{
+		return 0;
+	}
+	return erfc(fabs(runs - 2 * n * pi * (1 - pi)) / (2 * sqrt(2.0 * n) * pi * (1 - pi)));
+}
+
+static int compareDays(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+/* Marsaglia's birthday spacings: RNG_BIRTHDAYS birthdays of 24 bits each year, the number of
+repeated spacings is Poisson with mean RNG_BIRTHDAYS^3 / 2^26, summed over the years. */
+static double birthdayTest(rng_source *source)
+{
+	uint32_t days[RNG_BIRTHDAYS], symbol = 0, year, k, repeated;
+	uint8_t left = 0;
+	double lambda = pow(RNG_BIRTHDAYS, 3) / ldexp(1, 26) * RNG_BIRTHDAY_YEARS;
+	uint64_t total = 0;
+
+	for(year = 0; year < RNG_BIRTHDAY_YEARS; year++)
+	{
+		for(k = 0; k < RNG_BIRTHDAYS; k++)
+		{
+			days[k] = nextBits(source, 24, &symbol, &left);
+		}
+		qsort(days, RNG_BIRTHDAYS, sizeof(uint32_t), compareDays);
+		for(k = RNG_BIRTHDAYS - 1; k > 0; k--)
+		{
+			days[k] -= days[k - 1];
+		}
+		qsort(days + 1, RNG_BIRTHDAYS - 1, sizeof(uint32_t), compareDays);
+		for(k = 2, repeated = 0; k < RNG_BIRTHDAYS; k++)
+		{
+			repeated += (days[k] == days[k - 1]);
+		}
+		total += repeated;
+	}
+
+	return erfc(fabs(total - lambda) / sqrt(2 * lambda));
+}
+
+static double (*const tests[RNG_TESTS])(rng_source *source) = {frequencyTest, serialTest, gapTest, runsTest, birthdayTest};
+
+static double speedTest(const rng_generator *generator)
+{
+	struct timespec start, end;
+	volatile uint32_t sink;
+	uint32_t sum = 0;
+	uint64_t n;
+
+	generator->srand(RNG_SEED);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(n = 0; n < RNG_SPEED_DRAWS; n++)
+	{
+		sum += generator->rand();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	sink = sum;
+	(void) sink;
+
+	return RNG_SPEED_DRAWS / ((end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+}
+
+static int compareResults(const void *a, const void *b)
+{
+	const rng_result *x = a, *y = b;
+
+	if(x->passed != y->passed)
+	{
+		return y->passed - x->passed;
+	}
+	return (y->draws > x->draws) - (y->draws < x->draws);
+}
+
+int main(void)
+{
+	rng_view views[RNG_VIEWS] = {{"full", 8, 0}, {"low8", 8, 1}, {"index", 0, 1}};
+	char indexName[16];
+	rng_result results[RNG_GENERATORS];
+	rng_source source;
+	uint32_t g, v, t;
+
+	/* The GA draws indexes with random & (POPULATION_SIZE - 1). */
+	while((1UL << views[2].width) < POPULATION_SIZE)
+	{
+		views[2].width++;
+	}
+	snprintf(indexName, sizeof(indexName), "low%u", views[2].width);
+	views[2].name = indexName;
+
+	printf("%-10s %-6s", "generator", "bits");
+	for(t = 0; t < RNG_TESTS; t++)
+	{
+		printf(" %10s", testNames[t]);
+	}
+	printf("\n");
+
+	for(g = 0; g < RNG_GENERATORS; g++)
+	{
+		results[g].generator = &generators[g];
+		results[g].passed = 0;
+		for(v = 0; v < RNG_VIEWS; v++)
+		{
+			printf("%-10s %-6s", generators[g].name, views[v].name);
+			for(t = 0; t < RNG_TESTS; t++)
+			{
+				/* Each test starts from the same seed. */
+				memset(&source, 0, sizeof(source));
+				source.generator = &generators[g];
+				source.view = &views[v];
+				generators[g].srand(RNG_SEED);
+
+				results[g].p[v][t] = tests[t](&source);
+				results[g].passed += (results[g].p[v][t] >= RNG_ALPHA);
+				printf(" %9.4f%c", results[g].p[v][t], results[g].p[v][t] >= RNG_ALPHA ? ' ' : '*');
+			}
+			printf("\n");
+		}
+		results[g].draws = speedTest(&generators[g]);
+	}
+
+	qsort(results, RNG_GENERATORS, sizeof(rng_result), compareResults);
+
+	printf("\n(* p-value below %g)\n\n%-4s %-10s %6s %14s %10s\n", RNG_ALPHA, "rank", "generator", "passed", "draws/s", "MB/s");
+	for(g = 0; g < RNG_GENERATORS; g++)
+	{
+		printf("%-4u %-10s %3d/%-2d %14.0f %10.1f\n", g + 1, results[g].generator->name, results[g].passed,
+			RNG_VIEWS * RNG_TESTS, results[g].draws, results[g].draws * results[g].generator->bits / 8 / 1e6);
+	}
+
+	return 0;
+}
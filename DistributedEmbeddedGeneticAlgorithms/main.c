@@ -2,12 +2,15 @@
 #include "util/usart.h"
 #include "util/spi.h"
 #include "util/power.h"
+#include "util/checkpoint.h"
 #include "random/lfsr.h"
+#include "random/bench.h"
 
 #include <stdio.h>
 #include <stdint.h>
 #include <util/delay.h>
 #include <avr/interrupt.h>
+#include <avr/wdt.h>
 
 #ifndef PI
 #define PI 3.14159265358979323846
@@ -18,6 +21,11 @@
 #define REPEAT 8000
 #endif
 
+/* 1 to send the cycles per draw of each random generator through the USART at startup. */
+#ifndef RANDOM_BENCHMARK
+#define RANDOM_BENCHMARK 0
+#endif
+
 fitness_t evaluationFM2(normalization_t xn[])
 {
 	//return 21.5 + xn[0]*(sin(40*pi*xn[0]) + cos(20*pi*xn[0]) );
@@ -49,16 +57,23 @@ fitness_t evaluationFM(normalization_t xn[])
 
 int main(void)
 {
-	chromosome_t population[NODE_POPULATION_SIZE][DIMENSION];
-	fitness_t evaluation[NODE_POPULATION_SIZE];
+	population_t population[POPULATION_ROWS][POPULATION_COLUMNS];
+	fitness_t evaluation[NODE_POPULATION_MAX];
 	normalization_t normalizedChromosome[DIMENSION];
+#if INDIVIDUAL_COPY
+	chromosome_t x[DIMENSION];
+#endif
 	popsize_t iBest;
 	char output[100];
 	
+	/* The watchdog stays enabled after it resets the node (see rejoinFM). */
+	MCUSR = 0;
+	wdt_disable();
+	
 	/* Set ups the CPU prescaller. */
 	power_init();
 	
-	_delay_ms(1000);
+	power_delay_ms(1000);
 	
 	/* Enables interrupts */
 	sei();
@@ -69,6 +84,14 @@ int main(void)
 	/* Initialize PD7 as output - used by external timer. */
 	DDRD |= (1 << DDD7);
 	
+#if RANDOM_BENCHMARK
+	bench_random();
+#endif
+	
+#if RANDOM_STREAMS
+	/* Each node gets its own stream of the same seed, the master sends a new one at CMD_SYNC. */
+	seedFM(RANDOM_SEED);
+#else
 	/* Use internal temperature of each node as seed for LFSR. */
 #if NODE_ID == 0	
 	lfsr_srand8(101);
@@ -79,6 +102,7 @@ int main(void)
 	lfsr_srand16(55733);
 	lfsr_srand32(104729);
 #endif
+#endif
 
 
 	/* Enable master or slave SPI config */
@@ -90,7 +114,21 @@ int main(void)
 	//USART_send_string("[slave] system starting...\n");
 #endif
 
-	_delay_ms(100);
+#if CHECKPOINT_INTERVAL
+	/* Split the EEPROM into checkpoint slots and find the newest checkpoint. */
+	checkpoint_init(CHECKPOINT_BYTES);
+#endif
+
+#if BROADCAST_SELECT
+	/* The master pulls the ready line up and each slave holds it low while it is busy. */
+#if NODE_ID == 0
+	PORTD |= (1 << READY);
+#else
+	DDRD |= (1 << READY);
+#endif
+#endif
+
+	power_delay_ms(100);
 
 	while(1)
 	{	
@@ -104,7 +142,7 @@ int main(void)
 		PORTD &= ~(1 << DDD7);	
 		
 		/* Every node normalize their best result */
-		normalizationFM(population[iBest], normalizedChromosome);
+		normalizationFM(INDIVIDUAL(population, iBest, x), normalizedChromosome);
 		
 		/* Send result through USART connection */
 #if NODE_ID == 0
@@ -120,7 +158,7 @@ int main(void)
 		//USART_send_string("\n---\n");
 		
 		/* Busy wait 500 ms */
-		_delay_ms(2000);
+		power_delay_ms(2000);
 		
 	
 		
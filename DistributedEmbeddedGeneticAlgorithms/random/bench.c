@@ -0,0 +1,65 @@
+#include "bench.h"
+#include "lcg.h"
+#include "lfsr.h"
+#include "mt.h"
+#include "mwc.h"
+#include "sm.h"
+#include "xoshiro.h"
+#include "xs.h"
+#include "../util/counter.h"
+#include "../util/power.h"
+#include "../util/usart.h"
+
+#include <stdio.h>
+
+/* The draws are stored here so they are not optimized away. */
+volatile uint32_t bench_sink;
+
+/* Timer 1 counts every 1024 cycles, so the loop runs BENCH_DRAWS times and the cost of the loop
+itself (measured first) is taken out. */
+#define BENCH(name, draw) \
+	do \
+	{ \
+		counter_start(); \
+		for(i = 0; i < BENCH_DRAWS; i++) \
+		{ \
+			bench_sink = (draw); \
+		} \
+		cycles = counter_stop() * power_get_f_cpu() / BENCH_DRAWS - loop; \
+		sprintf(output, "[random] %-10s %5u cycles/draw\n", name, (unsigned) (cycles + 0.5)); \
+		USART_send_string(output); \
+	} \
+	while(0)
+
+void bench_random(void)
+{
+	uint16_t i;
+	float cycles, loop;
+	char output[40];
+	
+	lcg_srand(96233);
+	lfsr_srand32(96233);
+	lfsr_srand16(19207);
+	lfsr_srand8(101);
+	mt_srand(96233);
+	mwc_srand(96233);
+	sm_srand(96233);
+	xoshiro_srand(96233);
+	xs_srand(96233);
+	
+	loop = 0;
+	BENCH("loop", i);
+	loop = cycles;
+	
+	BENCH("lcg", lcg_rand());
+	BENCH("lfsr8", lfsr_rand8());
+	BENCH("lfsr16", lfsr_rand16());
+	BENCH("lfsr32", lfsr_rand32());
+	BENCH("mt", mt_rand());
+	BENCH("mwc", mwc_rand());
+	BENCH("sm", sm_rand());
+	BENCH("xoshiro8", xoshiro_rand8());
+	BENCH("xoshiro16", xoshiro_rand16());
+	BENCH("xoshiro32", xoshiro_rand32());
+	BENCH("xs", xs_rand());
+}
@@ -0,0 +1,14 @@
+/* Speed of the random generators on the device */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdint.h>
+
+#define BENCH_DRAWS 1024 /* Draws timed for each generator. */
+
+/* Time BENCH_DRAWS draws of each generator and send the cycles per draw through the USART. The
+generators are left seeded with fixed values, so seed the one used by the GA afterwards. */
+void bench_random(void);
+
+#endif /* BENCH_H_ */
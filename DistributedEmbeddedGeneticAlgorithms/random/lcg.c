@@ -1,5 +1,7 @@
 #include "lcg.h"
 
+static uint32_t rseed;
+
 inline void lcg_srand(uint32_t n)
 {
 	rseed = n;
@@ -9,14 +11,14 @@ inline void lcg_srand(uint32_t n)
 
 	inline uint32_t lcg_rand(void)
 	{
-		return rseed = (rseed * 1103515245 + 12345) & RAND_MAX;
+		return rseed = (rseed * 1103515245 + 12345) & LCG_RAND_MAX;
 	}
 
 #else /* MS rand */
 
 	inline uint32_t lcg_rand(void)
 	{
-		return (rseed = (rseed * 214013 + 2531011) & RAND_MAX_32) >> 16;
+		return (rseed = (rseed * 214013 + 2531011) & LCG_RAND_MAX_32) >> 16;
 	}
 
 #endif
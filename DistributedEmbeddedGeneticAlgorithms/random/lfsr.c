@@ -59,3 +59,17 @@ inline uint8_t lfsr_rand8(void)
 	return lfsr8;
 	
 }
+
+void lfsr_get_state(lfsr_state *state)
+{
+	state->s32 = lfsr32;
+	state->s16 = lfsr16;
+	state->s8 = lfsr8;
+}
+
+void lfsr_set_state(const lfsr_state *state)
+{
+	lfsr32 = state->s32;
+	lfsr16 = state->s16;
+	lfsr8 = state->s8;
+}
@@ -6,6 +6,13 @@
 
 #include <stdint.h>
 
+/* State of the three generators (saved in the checkpoints). */
+typedef struct {
+	uint32_t s32;
+	uint16_t s16;
+	uint8_t s8;
+} lfsr_state;
+
 void lfsr_srand32(uint32_t seed);
 void lfsr_srand16(uint16_t seed);
 void lfsr_srand8(uint8_t seed);
@@ -14,4 +21,7 @@ uint32_t lfsr_rand32(void);
 uint16_t lfsr_rand16(void);
 uint8_t lfsr_rand8(void);
 
+void lfsr_get_state(lfsr_state *state);
+void lfsr_set_state(const lfsr_state *state);
+
 #endif /* LFSR_H_ */
\ No newline at end of file
@@ -1,5 +1,13 @@
 #include "mt.h"
 
+#define N              (62)                 // length of state vector
+#define M              (39)                 // a period parameter
+#define K              (0x9908B0DFU)         // a magic constant
+#define hiBit(u)       ((u) & 0x80000000U)   // mask all but highest   bit of u
+#define loBit(u)       ((u) & 0x00000001U)   // mask all but lowest    bit of u
+#define loBits(u)      ((u) & 0x7FFFFFFFU)   // mask     the highest   bit of u
+#define mixBits(u, v)  (hiBit(u)|loBits(v))  // move hi bit of u to hi bit of v
+
 static uint32_t   state[N+1];     // state vector + 1 extra to not violate ANSI C
 static uint32_t   *next;          // next random value is computed from here
 static int      left = -1;      // can *next++ this many times before reloading
@@ -1,7 +1,10 @@
 #include "mwc.h"
 
-uint32_t Q[SIZE];
-uint32_t c;
+#define SIZE 64
+#define PHI 0x9e3779b9
+
+static uint32_t Q[SIZE];
+static uint32_t c;
 
 void mwc_srand(uint32_t n)
 {
@@ -18,9 +21,9 @@ void mwc_srand(uint32_t n)
 
 uint32_t mwc_rand(void)
 {
-	unsigned long long t, a = 18782LL;
-	static unsigned long i = SIZE-1;
-	unsigned long x, r = 0xfffffffe;
+	uint64_t t, a = 18782LL;
+	static uint8_t i = SIZE-1;
+	uint32_t x, r = 0xfffffffe;
 	
 	i = (i+1) & (SIZE-1);
 	t = a * Q[i] + c;
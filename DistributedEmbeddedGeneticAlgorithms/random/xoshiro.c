@@ -0,0 +1,152 @@
+#include "xoshiro.h"
+
+static uint32_t xoshiro[4] = {0x9E3779B9, 0x243F6A88, 0xB7E15162, 0x7F4A7C15};
+
+#if defined(__AVR__)
+
+/* avr-gcc calls __mulsi3 for 32-bit products and shifts one bit per instruction, so on the AVR
+the products by 5 and 9 are done with additions and the rotations move whole bytes first. */
+
+typedef union {
+	uint32_t word;
+	uint8_t bytes[4];
+} xoshiro_word;
+
+static inline uint32_t rotl8(uint32_t x)
+{
+	xoshiro_word in, out;
+	
+	in.word = x;
+	out.bytes[0] = in.bytes[3];
+	out.bytes[1] = in.bytes[0];
+	out.bytes[2] = in.bytes[1];
+	out.bytes[3] = in.bytes[2];
+	return out.word;
+}
+
+/* rotl(x, 7) = rotr(rotl(x, 8), 1) */
+static inline uint32_t rotl7(uint32_t x)
+{
+	x = rotl8(x);
+	return (x >> 1) | (x << 31);
+}
+
+/* rotl(x, 11) = rotl(rotl(x, 8), 3) */
+static inline uint32_t rotl11(uint32_t x)
+{
+	x = rotl8(x);
+	return (x << 3) | (x >> 29);
+}
+
+#define TIMES5(x) ((x) + ((x) << 2))
+#define TIMES9(x) ((x) + ((x) << 3))
+
+#else
+
+static inline uint32_t rotl(uint32_t x, uint8_t k)
+{
+	return (x << k) | (x >> (32 - k));
+}
+
+#define rotl7(x) rotl(x, 7)
+#define rotl11(x) rotl(x, 11)
+#define TIMES5(x) ((x) * 5)
+#define TIMES9(x) ((x) * 9)
+
+#endif
+
+/* The four words are taken from consecutive values of a 32-bit mixer, which is a bijection,
+so at most one of them is zero and the state is never all zeros. */
+void xoshiro_srand(uint32_t seed)
+{
+	uint32_t z;
+	uint8_t i;
+	
+	for(i = 0; i < 4; i++)
+	{
+		seed += 0x9E3779B9;
+		z = seed;
+		z = (z ^ (z >> 16)) * 0x85EBCA6B;
+		z = (z ^ (z >> 13)) * 0xC2B2AE35;
+		xoshiro[i] = z ^ (z >> 16);
+	}
+}
+
+uint32_t xoshiro_rand32(void)
+{
+	uint32_t result = xoshiro[1];
+	uint32_t t = xoshiro[1] << 9;
+	
+	result = TIMES5(result);
+	result = rotl7(result);
+	result = TIMES9(result);
+	
+	xoshiro[2] ^= xoshiro[0];
+	xoshiro[3] ^= xoshiro[1];
+	xoshiro[1] ^= xoshiro[2];
+	xoshiro[0] ^= xoshiro[3];
+	xoshiro[2] ^= t;
+	xoshiro[3] = rotl11(xoshiro[3]);
+	
+	return result;
+}
+
+/* The upper bits are the best ones. */
+uint16_t xoshiro_rand16(void)
+{
+	return (uint16_t) (xoshiro_rand32() >> 16);
+}
+
+uint8_t xoshiro_rand8(void)
+{
+	return (uint8_t) (xoshiro_rand32() >> 24);
+}
+
+/* Advances the generator by 2^64 numbers, so calling it n times gives the n-th of 2^64
+streams that do not overlap. */
+void xoshiro_jump(void)
+{
+	static const uint32_t jump[4] = {0x8764000B, 0xF542D2D3, 0x6FA035C3, 0x77F2DB5B};
+	uint32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	uint8_t i, b;
+	
+	for(i = 0; i < 4; i++)
+	{
+		for(b = 0; b < 32; b++)
+		{
+			if(jump[i] & ((uint32_t) 1 << b))
+			{
+				s0 ^= xoshiro[0];
+				s1 ^= xoshiro[1];
+				s2 ^= xoshiro[2];
+				s3 ^= xoshiro[3];
+			}
+			xoshiro_rand32();
+		}
+	}
+	
+	xoshiro[0] = s0;
+	xoshiro[1] = s1;
+	xoshiro[2] = s2;
+	xoshiro[3] = s3;
+}
+
+void xoshiro_get_state(xoshiro_state *state)
+{
+	uint8_t i;
+	
+	for(i = 0; i < 4; i++)
+	{
+		state->s[i] = xoshiro[i];
+	}
+}
+
+void xoshiro_set_state(const xoshiro_state *state)
+{
+	uint8_t i;
+	
+	for(i = 0; i < 4; i++)
+	{
+		xoshiro[i] = state->s[i];
+	}
+}
@@ -0,0 +1,23 @@
+/* xoshiro128** generator */
+
+#ifndef XOSHIRO_H_
+#define XOSHIRO_H_
+
+#include <stdint.h>
+
+/* State of the generator (saved in the checkpoints). */
+typedef struct {
+	uint32_t s[4];
+} xoshiro_state;
+
+void xoshiro_srand(uint32_t seed);
+void xoshiro_jump(void);
+
+uint32_t xoshiro_rand32(void);
+uint16_t xoshiro_rand16(void);
+uint8_t xoshiro_rand8(void);
+
+void xoshiro_get_state(xoshiro_state *state);
+void xoshiro_set_state(const xoshiro_state *state);
+
+#endif /* XOSHIRO_H_ */
@@ -1,5 +1,7 @@
 #include "xs.h"
 
+static uint32_t seed;
+
 inline void xs_srand(uint32_t n)
 {
 	seed = n;
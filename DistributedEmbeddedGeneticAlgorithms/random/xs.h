@@ -5,8 +5,6 @@
 
 #include <stdint.h>
 
-uint32_t seed; 
-
 void xs_srand(uint32_t n);
 uint32_t xs_rand(void);
 
@@ -0,0 +1,205 @@
+#include "checkpoint.h"
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+
+#define CHECKPOINT_SLOT_ADDRESS(slot) ((slot) * checkpoint_slot_size)
+
+/* Header of a slot. */
+typedef struct {
+	uint16_t epoch;
+	uint16_t generation;
+	uint16_t size;
+	uint16_t crc;
+} checkpoint_header;
+
+/* Size and number of the slots and slot of the newest checkpoint. */
+static uint16_t checkpoint_slot_size = CHECKPOINT_EEPROM_SIZE;
+static uint8_t checkpoint_slots = 1;
+static uint8_t checkpoint_newest;
+
+/* Slot, position and CRC of the checkpoint being written or read. */
+static uint8_t checkpoint_slot;
+static uint16_t checkpoint_offset;
+static uint16_t checkpoint_crc;
+
+/* Adds the fields of a header (all but the CRC) to the CRC of the data, so a torn header is also detected. */
+static uint16_t checkpoint_header_crc(uint16_t crc, const checkpoint_header *header)
+{
+	crc = _crc_ccitt_update(crc, header->epoch & 0xFF);
+	crc = _crc_ccitt_update(crc, header->epoch >> 8);
+	crc = _crc_ccitt_update(crc, header->generation & 0xFF);
+	crc = _crc_ccitt_update(crc, header->generation >> 8);
+	crc = _crc_ccitt_update(crc, header->size & 0xFF);
+	crc = _crc_ccitt_update(crc, header->size >> 8);
+	
+	return crc;
+}
+
+/* Returns the generation of the checkpoint stored in a slot (and its epoch) or CHECKPOINT_NONE if it is empty or damaged. */
+static uint16_t checkpoint_generation(uint8_t slot, uint16_t *epoch)
+{
+	checkpoint_header header;
+	uint16_t crc;
+	uint16_t i;
+	
+	eeprom_read_block(&header, (const void *) CHECKPOINT_SLOT_ADDRESS(slot), sizeof(header));
+	
+	if(header.size > checkpoint_slot_size - CHECKPOINT_HEADER_SIZE)
+	{
+		return CHECKPOINT_NONE;
+	}
+	
+	/* A write interrupted by a reset (of the data or of the header) leaves a wrong CRC. */
+	crc = 0xFFFF;
+	for(i = 0; i < header.size; i++)
+	{
+		crc = _crc_ccitt_update(crc, eeprom_read_byte((const uint8_t *) (CHECKPOINT_SLOT_ADDRESS(slot) + CHECKPOINT_HEADER_SIZE + i)));
+	}
+	
+	if(checkpoint_header_crc(crc, &header) != header.crc)
+	{
+		return CHECKPOINT_NONE;
+	}
+	
+	*epoch = header.epoch;
+	return header.generation;
+}
+
+/* Returns 1 if the first checkpoint is newer than the second (a newer run has a greater epoch). */
+static uint8_t checkpoint_newer(uint16_t epoch, uint16_t generation, uint16_t other_epoch, uint16_t other_generation)
+{
+	return epoch > other_epoch || (epoch == other_epoch && generation > other_generation);
+}
+
+/* Splits the EEPROM into slots for checkpoints of up to size bytes and finds the newest checkpoint. */
+void checkpoint_init(uint16_t size)
+{
+	uint16_t epochs[CHECKPOINT_RECENT];
+	uint16_t generations[CHECKPOINT_RECENT];
+	uint16_t epoch;
+	uint8_t slot;
+	
+	checkpoint_slot_size = CHECKPOINT_HEADER_SIZE + size;
+	checkpoint_slots = CHECKPOINT_EEPROM_SIZE / checkpoint_slot_size;
+	
+	/* Without checkpoints, the first one goes to the first slot. */
+	checkpoint_newest = checkpoint_slots - 1;
+	
+	checkpoint_recent(epochs, generations);
+	if(generations[0] == CHECKPOINT_NONE)
+	{
+		return;
+	}
+	
+	for(slot = 0; slot < checkpoint_slots; slot++)
+	{
+		if(checkpoint_generation(slot, &epoch) == generations[0] && epoch == epochs[0])
+		{
+			checkpoint_newest = slot;
+		}
+	}
+}
+
+/* Returns the epoch and the generation of the CHECKPOINT_RECENT newest checkpoints, newest first (CHECKPOINT_NONE if there are fewer). */
+void checkpoint_recent(uint16_t epochs[], uint16_t generations[])
+{
+	uint16_t epoch;
+	uint16_t generation;
+	uint8_t slot;
+	uint8_t i;
+	
+	for(i = 0; i < CHECKPOINT_RECENT; i++)
+	{
+		epochs[i] = 0;
+		generations[i] = CHECKPOINT_NONE;
+	}
+	
+	for(slot = 0; slot < checkpoint_slots; slot++)
+	{
+		generation = checkpoint_generation(slot, &epoch);
+		if(generation == CHECKPOINT_NONE)
+		{
+			continue;
+		}
+		
+		/* Insert it in order, the older ones move down the list. */
+		for(i = CHECKPOINT_RECENT; i > 0 && (generations[i - 1] == CHECKPOINT_NONE || checkpoint_newer(epoch, generation, epochs[i - 1], generations[i - 1])); i--)
+		{
+			if(i < CHECKPOINT_RECENT)
+			{
+				epochs[i] = epochs[i - 1];
+				generations[i] = generations[i - 1];
+			}
+		}
+		
+		if(i < CHECKPOINT_RECENT)
+		{
+			epochs[i] = epoch;
+			generations[i] = generation;
+		}
+	}
+}
+
+/* Starts a new checkpoint in the slot after the newest one. */
+void checkpoint_begin(void)
+{
+	checkpoint_slot = (checkpoint_newest + 1) % checkpoint_slots;
+	checkpoint_offset = 0;
+	checkpoint_crc = 0xFFFF;
+}
+
+/* Appends data to the checkpoint being written. */
+void checkpoint_write(const void *data, uint16_t size)
+{
+	uint16_t i;
+	
+	/* Unchanged bytes are not written again. */
+	eeprom_update_block(data, (void *) (CHECKPOINT_SLOT_ADDRESS(checkpoint_slot) + CHECKPOINT_HEADER_SIZE + checkpoint_offset), size);
+	
+	for(i = 0; i < size; i++)
+	{
+		checkpoint_crc = _crc_ccitt_update(checkpoint_crc, ((const uint8_t *) data)[i]);
+	}
+	checkpoint_offset += size;
+}
+
+/* Writes the header, which validates the checkpoint. */
+void checkpoint_commit(uint16_t epoch, uint16_t generation)
+{
+	checkpoint_header header;
+	
+	header.epoch = epoch;
+	header.generation = generation;
+	header.size = checkpoint_offset;
+	header.crc = checkpoint_header_crc(checkpoint_crc, &header);
+	
+	eeprom_update_block(&header, (void *) CHECKPOINT_SLOT_ADDRESS(checkpoint_slot), sizeof(header));
+	
+	checkpoint_newest = checkpoint_slot;
+}
+
+/* Opens the checkpoint of a given epoch and generation for reading. Returns 1 if it was found. */
+uint8_t checkpoint_open(uint16_t epoch, uint16_t generation)
+{
+	uint16_t found;
+	uint8_t slot;
+	
+	for(slot = 0; slot < checkpoint_slots; slot++)
+	{
+		if(checkpoint_generation(slot, &found) == generation && found == epoch)
+		{
+			checkpoint_slot = slot;
+			checkpoint_offset = 0;
+			return 1;
+		}
+	}
+	
+	return 0;
+}
+
+/* Reads data from the opened checkpoint. */
+void checkpoint_read(void *data, uint16_t size)
+{
+	eeprom_read_block(data, (const void *) (CHECKPOINT_SLOT_ADDRESS(checkpoint_slot) + CHECKPOINT_HEADER_SIZE + checkpoint_offset), size);
+	checkpoint_offset += size;
+}
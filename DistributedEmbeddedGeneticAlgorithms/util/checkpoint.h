@@ -0,0 +1,40 @@
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <stdint.h>
+
+/*
+EEPROM layout: the whole EEPROM is split into as many slots as fit. Each slot stores a header (epoch,
+generation, size and a CRC of the data and of the other fields) and the data. New checkpoints go to the
+slot after the newest one, so the slots (and their headers) are written in turns and the wear is spread
+over the whole EEPROM. Nothing else is stored: the epoch of a run is told by the epochs of the checkpoints.
+*/
+#define CHECKPOINT_EEPROM_SIZE 1024 /* ATmega328P. */
+#define CHECKPOINT_HEADER_SIZE 8
+#define CHECKPOINT_MAX_SIZE (CHECKPOINT_EEPROM_SIZE / 2 - CHECKPOINT_HEADER_SIZE) /* The newest checkpoint must survive while the next one is written. */
+#define CHECKPOINT_RECENT 2 /* Number of checkpoints returned by checkpoint_recent. */
+
+#define CHECKPOINT_NONE 0xFFFF /* Generation of an empty (or damaged) slot. */
+
+/* Splits the EEPROM into slots for checkpoints of up to size bytes and finds the newest checkpoint. */
+void checkpoint_init(uint16_t size);
+
+/* Returns the epoch and the generation of the CHECKPOINT_RECENT newest checkpoints, newest first (CHECKPOINT_NONE if there are fewer). */
+void checkpoint_recent(uint16_t epochs[], uint16_t generations[]);
+
+/* Starts a new checkpoint in the slot after the newest one. */
+void checkpoint_begin(void);
+
+/* Appends data to the checkpoint being written. */
+void checkpoint_write(const void *data, uint16_t size);
+
+/* Writes the header, which validates the checkpoint. */
+void checkpoint_commit(uint16_t epoch, uint16_t generation);
+
+/* Opens the checkpoint of a given epoch and generation for reading. Returns 1 if it was found. */
+uint8_t checkpoint_open(uint16_t epoch, uint16_t generation);
+
+/* Reads data from the opened checkpoint. */
+void checkpoint_read(void *data, uint16_t size);
+
+#endif /* CHECKPOINT_H_ */
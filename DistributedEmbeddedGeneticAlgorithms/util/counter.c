@@ -8,6 +8,9 @@
 #include "counter.h"
 #include <avr/io.h>
 
+/* CPU clock when the counter started, the ticks follow it even if the clock switches later. */
+static uint32_t counter_f_cpu = BASE_F_CPU;
+
 /* Configure the counter. */
 void counter_init(void)
 {
@@ -17,6 +20,8 @@ void counter_init(void)
 /* Start the counter. */
 void counter_start(void)
 {
+	counter_f_cpu = power_get_f_cpu();
+	
 	/* Initial value of the timer. */
 	TCNT1 = 0;
 	
@@ -33,3 +38,9 @@ float counter_stop(void)
 	return TCNT1 * COUNTER_INTERVAL;
 }
 
+/* Duration of a tick at the clock of the last counter_start. */
+float counter_interval(void)
+{
+	return PRESCALLER / counter_f_cpu;
+}
+
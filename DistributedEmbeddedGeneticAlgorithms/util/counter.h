@@ -8,12 +8,12 @@
 #ifndef COUNTER_H_
 #define COUNTER_H_
 
-#define CLOCK 16000000L
-#define PRESCALLER 1024.0
-#define COUNTER_INTERVAL 1.0/(CLOCK/PRESCALLER)
-
+#include "power.h"
 #include <stdint.h>
 
+#define PRESCALLER 1024.0
+#define COUNTER_INTERVAL counter_interval() /* Tick of the last count, at the clock it was counted at. */
+
 /* Configure the counter. */
 void counter_init(void);
 
@@ -23,4 +23,7 @@ void counter_start(void);
 /* Stop the counter. */
 float counter_stop(void);
 
+/* Duration of a tick at the clock of the last counter_start. */
+float counter_interval(void);
+
 #endif /* COUNTER_H_ */
\ No newline at end of file
@@ -1,11 +1,37 @@
 #include "power.h"
+#include "usart.h"
+#include "timeout.h"
 #include <avr/power.h>
+#include <util/delay.h>
+
+/* Current clock divider (0 until power_init runs). */
+static volatile uint8_t power_div = 0;
 
 /* Initializes the power configuration. */
 void power_init(void)
 {
 	/* Reduce base clock (F_CPU is defined in USART). */
-	switch (CPU_DIV)
+	power_set_div(CPU_DIV);
+	
+	/* Disable other peripherals that are not being used.*/
+	// power_aca_disable(); /* Disable the Analog Comparator on PortA. */
+	// power_adc_disable(); /* Disable the Analog to Digital Converter module. */
+	// power_adca_disable(); /* Disable the Analog to Digital Converter module. */
+	
+}
+
+/* Changes the clock divider at runtime and updates the USART baud rate. */
+void power_set_div(uint8_t div)
+{
+	if(div == power_div)
+	{
+		return;
+	}
+	
+	/* Do not cut a byte that is still being shifted out (an empty data register is not enough). */
+	USART_flush();
+	
+	switch (div)
 	{
 		case 2:
 			clock_prescale_set(clock_div_2);
@@ -20,13 +46,40 @@ void power_init(void)
 			clock_prescale_set(clock_div_16);
 			break;
 		default:
+			div = 1;
 			clock_prescale_set(clock_div_1);
 			break;
 	}
 	
-	/* Disable other peripherals that are not being used.*/
-	// power_aca_disable(); /* Disable the Analog Comparator on PortA. */
-	// power_adc_disable(); /* Disable the Analog to Digital Converter module. */
-	// power_adca_disable(); /* Disable the Analog to Digital Converter module. */
+	power_div = div;
 	
-}
\ No newline at end of file
+	/* The baud rate register and the period of the timeouts depend on the CPU clock. */
+	USART_update_baud();
+	timeout_update_clock();
+}
+
+/* Returns the current clock divider. */
+uint8_t power_get_div(void)
+{
+	return power_div;
+}
+
+/* Returns the current CPU clock in Hz. */
+uint32_t power_get_f_cpu(void)
+{
+	return BASE_F_CPU / power_div;
+}
+
+/* Busy wait that stays correct for any clock divider (_delay_ms only knows F_CPU). */
+void power_delay_ms(uint16_t ms)
+{
+	uint32_t steps;
+	
+	/* _delay_us(100) lasts 100 us * power_div / CPU_DIV, so scale the number of steps. */
+	steps = ((uint32_t) ms * 10 * CPU_DIV) / power_div;
+	
+	while(steps--)
+	{
+		_delay_us(100);
+	}
+}
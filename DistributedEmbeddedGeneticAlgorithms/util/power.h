@@ -1,12 +1,31 @@
 #ifndef POWER_H_
 #define POWER_H_
 
+#include <stdint.h>
+
 #define BASE_F_CPU 16000000UL  /* Base CPU clock = 16 MHz. */
-#define CPU_DIV 2
+#define CPU_DIV 2 /* Divider used at startup (1, 2, 4, 8 or 16). */
 
 #define F_CPU BASE_F_CPU/CPU_DIV
 
+/* Runtime clock scaling: full speed while computing and transferring, slow while waiting for the other nodes. */
+#define POWER_SCALING 1 /* 0 keeps CPU_DIV for the whole run. */
+#define CPU_DIV_FAST 1 /* Divider used while computing and transferring. */
+#define CPU_DIV_SLOW 16 /* Divider used while a slave waits for a command or the master waits for the slaves. */
+
 /* Initializes the power configuration. */
 void power_init(void);
 
-#endif /* POWER_H_ */
\ No newline at end of file
+/* Changes the clock divider at runtime and updates the USART baud rate. */
+void power_set_div(uint8_t div);
+
+/* Returns the current clock divider. */
+uint8_t power_get_div(void);
+
+/* Returns the current CPU clock in Hz. */
+uint32_t power_get_f_cpu(void);
+
+/* Busy wait that stays correct for any clock divider (_delay_ms only knows F_CPU). */
+void power_delay_ms(uint16_t ms);
+
+#endif /* POWER_H_ */
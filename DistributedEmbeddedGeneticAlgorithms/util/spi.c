@@ -2,6 +2,7 @@
 #include "spi.h"
 #include <stdio.h>
 #include "usart.h"
+#include "power.h"
 #include <util/delay.h>
 
 /* Initialize the SPI master device. */
@@ -27,10 +28,30 @@ void SPI_slave_init(void)
 	SPCR |= (1 << SPE);
 }
 
+/* SPR1 and SPR0 (bits 1 and 0) and SPI2X (bit 2) of each clock setting: fosc/2, 4, 8, 16, 32, 64 and 128. */
+static const uint8_t clock_settings[SPI_CLOCK_SLOWEST + 1] = {0x04, 0x00, 0x05, 0x01, 0x06, 0x02, 0x03};
+
+void SPI_master_set_clock(uint8_t setting)
+{
+	uint8_t bits = clock_settings[setting];
+	
+	SPCR = (SPCR & ~((1 << SPR1) | (1 << SPR0))) | (bits & 0x03);
+	
+	/* SPI2X doubles the clock. */
+	if(bits & 0x04)
+	{
+		SPSR |= (1 << SPI2X);
+	}
+	else
+	{
+		SPSR &= ~(1 << SPI2X);
+	}
+}
+
 void SPI_master_send_byte(uint8_t ss, uint8_t data)
 {
 	/* Enable the selected slave */
-	PORTB &= !(1 << ss);
+	PORTB &= ~(1 << ss);
 	
 	while(1)
 	{
@@ -48,7 +69,7 @@ void SPI_master_send_byte(uint8_t ss, uint8_t data)
 		}
 		
 		/* Delay necessary to not break the SPI (during polling). */
-		_delay_ms(10);
+		power_delay_ms(10);
 	}
 	
 	/* Send the useful data */
@@ -64,7 +85,7 @@ uint8_t SPI_master_receive_byte(uint8_t ss)
 	uint8_t data;
 	
 	/* Enable the selected slave */
-	PORTB &= !(1 << ss);
+	PORTB &= ~(1 << ss);
 
 	while(1)
 	{
@@ -82,7 +103,7 @@ uint8_t SPI_master_receive_byte(uint8_t ss)
 		}
 	
 		/* Delay necessary to not break the SPI (during polling). */
-		_delay_ms(10);
+		power_delay_ms(10);
 	}
 
 	/* Send the useful data */
@@ -146,7 +167,7 @@ void SPI_master_send_float(float data, uint8_t ss)
 	sent.value = data;
 	
 	/* Enable the selected slave */
-	PORTB &= !(1 << ss);
+	PORTB &= ~(1 << ss);
 	
 	while(1)
 	{		
@@ -164,7 +185,7 @@ void SPI_master_send_float(float data, uint8_t ss)
 		}
 		
 		/* Delay necessary to not break the SPI (during polling). */
-		_delay_ms(5);
+		power_delay_ms(5);
 	}
 	
 	/* Now send the 4 bytes. */
@@ -184,7 +205,7 @@ float SPI_master_receive_float(uint8_t ss)
 	uint8_t b;
 		
 	/* Enable the selected slave */
-	PORTB &= !(1 << ss);
+	PORTB &= ~(1 << ss);
 		
 	while(1)
 	{
@@ -202,7 +223,7 @@ float SPI_master_receive_float(uint8_t ss)
 		}
 			
 		/* Delay necessary to not break the SPI (during polling). */
-		_delay_ms(5);
+		power_delay_ms(5);
 			
 	}
 		
@@ -8,6 +8,7 @@ MOSI - Master Output Slave Input - PB3
 SS2 - Slave Select - PB2
 SS1 - Slave Select - PB1
 SS0 - Slave Select - PB0
+READY - Ready line of the slaves (wired-AND) - PD6
 */
 #define SCK 5
 #define MISO 4
@@ -16,8 +17,18 @@ SS0 - Slave Select - PB0
 #define SS1 1
 #define SS0 0
 
+/* Pin of the ready line in PORTD (see BROADCAST_SELECT). */
+#define READY 6
+
+/* Slave select pin of each slave (node 1 uses SS2). */
+#define SLAVE_SELECT(nodeId) (3 - (nodeId))
+
 #define DUMMY 0x00
 
+/* SPI clock settings of the master, from fosc/2 to fosc/128 (each one halves the clock). */
+#define SPI_CLOCK_FASTEST 0
+#define SPI_CLOCK_SLOWEST 6
+
 #define CMD_SEND_BYTE 0xC0
 #define ACK_SEND_BYTE 0xA0
 #define CMD_RECEIVE_BYTE 0xC1
@@ -45,6 +56,51 @@ SS0 - Slave Select - PB0
 #define CMD_SYNC 0xC9
 #define ACK_SYNC 0xA9
 
+#define CMD_PARTITION 0xCA
+#define ACK_PARTITION 0xAA
+
+#define CMD_COLLECT_CALIBRATION 0xCB
+#define ACK_COLLECT_CALIBRATION 0xAB
+
+#define CMD_EVALUATE_BATCH 0xCC
+#define ACK_EVALUATE_BATCH 0xAC
+
+#define CMD_COLLECT_BATCH 0xCD
+#define ACK_COLLECT_BATCH 0xAD
+
+#define CMD_COLLECT_CHECKPOINT 0xCE
+#define ACK_COLLECT_CHECKPOINT 0xAE
+
+#define CMD_RESUME 0xCF
+#define ACK_RESUME 0xAF
+
+#define CMD_COLLECT_EV_BATCH 0xD0
+#define ACK_COLLECT_EV_BATCH 0xB0
+
+#define CMD_TOURNAMENT_BATCH 0xD1
+#define ACK_TOURNAMENT_BATCH 0xB1
+
+#define CMD_SEND_IND_BATCH 0xD2
+#define ACK_SEND_IND_BATCH 0xB2
+
+#define CMD_LINK_TEST 0xD3
+#define ACK_LINK_TEST 0xB3
+
+#define CMD_LINK_DONE 0xD4
+#define ACK_LINK_DONE 0xB4
+
+#define CMD_COLLECT_BORDER 0xD5
+#define ACK_COLLECT_BORDER 0xB5
+
+#define CMD_SEND_HALO 0xD6
+#define ACK_SEND_HALO 0xB6
+
+#define CMD_COLLECT_CONTENDERS 0xD7
+#define ACK_COLLECT_CONTENDERS 0xB7
+
+/* It is sent to all slaves at once, so it has no ACK. */
+#define CMD_BROADCAST_CONTINUE 0xD8
+
 /* This union is used to break a float in 4 individual bytes. */
 typedef union {
 	uint8_t bytes[sizeof(float)];
@@ -72,6 +128,9 @@ void SPI_master_init(void);
 /* Initialize the SPI slave device. */
 void SPI_slave_init(void);
 
+/* Set the SPI clock of the master (SPI_CLOCK_FASTEST to SPI_CLOCK_SLOWEST). */
+void SPI_master_set_clock(uint8_t setting);
+
 /* These functions uses polling. */
 void SPI_master_send_byte(uint8_t ss, uint8_t data);
 uint8_t SPI_master_receive_byte(uint8_t ss);
@@ -0,0 +1,76 @@
+#include "timeout.h"
+#include "power.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+/* Milliseconds left before the timeout expires. */
+static volatile uint16_t timeout_remaining;
+
+/* Called every millisecond. */
+ISR(TIMER2_COMPA_vect)
+{
+	if(timeout_remaining > 0)
+	{
+		timeout_remaining--;
+	}
+}
+
+/* Starts a timeout of ms milliseconds (uses timer 2 and its interrupt). */
+void timeout_start(uint16_t ms)
+{
+	/* Stop the timer while it is configured. */
+	TCCR2B = 0;
+	TCNT2 = 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		timeout_remaining = ms;
+	}
+	
+	/* CTC mode with a period of 1 ms for the current clock (prescaller 64). */
+	TCCR2A = (1 << WGM21);
+	OCR2A = (uint8_t) (power_get_f_cpu() / 64000UL - 1);
+	TIMSK2 |= (1 << OCIE2A);
+	
+	/* Set prescaller to 64 and starts the timer. */
+	TCCR2B = (1 << CS22);
+}
+
+/* Keeps the period of 1 ms after a clock switch (called by power_set_div). */
+void timeout_update_clock(void)
+{
+	/* Nothing to do if no timeout is running. */
+	if(!TCCR2B)
+	{
+		return;
+	}
+	
+	OCR2A = (uint8_t) (power_get_f_cpu() / 64000UL - 1);
+	
+	/* A count above the new period would only be matched after the timer wraps around. */
+	if(TCNT2 > OCR2A)
+	{
+		TCNT2 = 0;
+	}
+}
+
+/* Returns 1 if the timeout has expired. */
+uint8_t timeout_expired(void)
+{
+	uint16_t remaining;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		remaining = timeout_remaining;
+	}
+	
+	return remaining == 0;
+}
+
+/* Stops the timer. */
+void timeout_stop(void)
+{
+	TCCR2B = 0;
+	TIMSK2 &= ~(1 << OCIE2A);
+}
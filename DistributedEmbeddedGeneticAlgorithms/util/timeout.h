@@ -0,0 +1,18 @@
+#ifndef TIMEOUT_H_
+#define TIMEOUT_H_
+
+#include <stdint.h>
+
+/* Starts a timeout of ms milliseconds (uses timer 2 and its interrupt). */
+void timeout_start(uint16_t ms);
+
+/* Keeps the period of 1 ms after a clock switch (called by power_set_div). */
+void timeout_update_clock(void);
+
+/* Returns 1 if the timeout has expired. */
+uint8_t timeout_expired(void);
+
+/* Stops the timer. */
+void timeout_stop(void);
+
+#endif /* TIMEOUT_H_ */
@@ -1,12 +1,14 @@
 #include "usart.h"
 #include <avr/interrupt.h>
 
+/* 1 once a byte was sent (TXC0 is only set after the first transmission). */
+static volatile uint8_t usart_sent = 0;
+
 /* Configure the USART. */
 void USART_init(void) 
 {
 	/* Set baud rate */
-	UBRR0H = (unsigned char) (BAUD_PRESCALLER >> 8);
-	UBRR0L = (unsigned char) (BAUD_PRESCALLER);
+	USART_update_baud();
 	
 	/* Enable receiver and transmitter */
 	UCSR0B |= (1 << RXEN0) | (1 << TXEN0);
@@ -15,16 +17,44 @@ void USART_init(void)
 	UCSR0C |= (1 << UCSZ01) | (1 << UCSZ00) | (1 << UPM00) | (1 << UPM01);	
 }
 
+/* Recalculate the baud rate for the current CPU clock (called after each clock switch). */
+void USART_update_baud(void)
+{
+	uint16_t prescaller;
+	
+	/* Double speed keeps the error below 1% down to 1 MHz (CPU_DIV_SLOW = 16). */
+	prescaller = BAUD_PRESCALLER_2X(power_get_f_cpu());
+	
+	/* Written with a mask, since writing back a pending TXC0 would clear it (and USART_flush would never return). */
+	UCSR0A = (UCSR0A & (1 << MPCM0)) | (1 << U2X0);
+	UBRR0H = (unsigned char) (prescaller >> 8);
+	UBRR0L = (unsigned char) (prescaller);
+}
+
 /* Send one byte (with polling). */
 void USART_send_byte(char data)
 {
 	/* Wait for empty transmit buffer. */
 	while(!(UCSR0A & (1 << UDRE0)));
 	
+	/* Clear the transmit complete flag (writing a one), it is set again when this byte is shifted out. */
+	UCSR0A = (UCSR0A & ((1 << U2X0) | (1 << MPCM0))) | (1 << TXC0);
+	usart_sent = 1;
+	
 	/* Put data into buffer, then sends the data. */
 	UDR0 = data;	
 }
 
+/* Wait until the last byte has been shifted out. */
+void USART_flush(void)
+{
+	if(usart_sent)
+	{
+		while(!(UCSR0A & (1 << TXC0)));
+		usart_sent = 0;
+	}
+}
+
 /* Send one string (with polling). */
 void USART_send_string(char* string){
 	while(*string != '\0')
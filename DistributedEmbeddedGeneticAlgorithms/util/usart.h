@@ -5,15 +5,20 @@
 
 #define BAUD 9600
 #define BAUD_PRESCALLER (((F_CPU / (BAUD * 16UL))) - 1)  /* The formula that does all the required maths. */
+#define BAUD_PRESCALLER_2X(f) ((((f) + BAUD * 4UL) / (BAUD * 8UL)) - 1) /* Double speed mode, rounded, for any clock. */
 
 #include <avr/io.h>
 
 /* Configure the USART. */
 void USART_init(void);
 
+/* Recalculate the baud rate for the current CPU clock (called after each clock switch). */
+void USART_update_baud(void);
+
 /* All these functions works with polling (slow). */
 void USART_send_byte(char data);
 void USART_send_string(char* string);
+void USART_flush(void);
 char USART_receive_byte (void);
 
 #endif /* USART_H_ */
\ No newline at end of file